@@ -9,6 +9,21 @@
 #define OS_RESERVED 300
 #define WORD_DIGITS 8
 
+// Memoria del SO (0 a OS_RESERVED-1)
+//   0-29                      vector de interrupciones y manejadores
+//   SHM_POOL                  segmentos de memoria compartida (ver shm.h)
+//   PIPE_POOL                 buffers de los tubos (ver pipe.h)
+//   KERNEL_STACK_LIMIT-299    pila del sistema (empieza en SYSTEM_STACK_BASE y baja)
+#define SHM_POOL_START 40
+#define SHM_POOL_WORDS 128
+#define PIPE_POOL_START 168
+#define PIPE_POOL_WORDS 32
+#define KERNEL_STACK_LIMIT 200
+#define SYSTEM_STACK_BASE 299
+
+// Dirección lógica donde un proceso ve su segmento compartido (fuera de su partición)
+#define SHM_LOGICAL_BASE 1000
+
 // Modos de Operacion
 #define USER_MODE 0
 #define KERNEL_MODE 1
@@ -65,6 +80,33 @@
 #define OP_SDMAIO 31 // Establece si es I/O (0 = read memory | 1 = write memory)
 #define OP_SDMAM 32 // Establece la posición de memoria a ser accedida
 #define OP_SDMAON 33 // Inicia DMA
+// Atómicas (una sola transacción de bus)
+#define OP_FADD 34 // Fetch-and-add: M[d] += AC, AC = valor previo
+#define OP_XCHG 35 // Intercambio: AC <-> M[d]
+#define OP_CAS 36  // Compare-and-swap: si M[d] == M[SP] entonces M[d] = AC; AC = valor previo
+// Bloque sobre [d, d+RX) (interrumpibles entre tramos de palabras, progreso en BLK)
+#define OP_BMOV 37  // Copia M[d..] a M[AC..]
+#define OP_BFILL 38 // Llena M[d..] con AC
+#define OP_BCMP 39  // Compara M[d..] con M[AC..]: CC como COMP, AC = palabras iguales
+#define OP_BSUM 40  // AC = suma de M[d..]
+// Subrutinas
+#define OP_CALL 41 // Apila PC de retorno y salta a d
+#define OP_RET 42  // Desapila PC
+// Saltos por código de condición (PSW.CC, sin leer la pila)
+#define OP_JZ 43   // CC == 0 (cero / igual)
+#define OP_JNZ 44  // CC != 0
+#define OP_JNEG 45 // CC == 1 (negativo / menor)
+#define OP_JPOS 46 // CC == 2 (positivo / mayor)
+#define OP_JOVF 47 // CC == 3 (overflow)
+// Registro a registro. Operando 000DS: Rd <- Rd op Rs (modo 0)
+// o DNNNN: Rd <- Rd op NNNN (modo 1). Registros 0-7 = R0-R7, 8 = AC, 9 = RX
+// El inmediato NNNN va de 0 a 9999 (no hay signo): un negativo se obtiene con SUBR
+#define OP_MOVR 48 // Rd = fuente
+#define OP_ADDR 49 // Rd = Rd + fuente
+#define OP_SUBR 50 // Rd = Rd - fuente
+#define OP_MULR 51 // Rd = Rd * fuente
+#define OP_DIVR 52 // Rd = Rd / fuente
+#define OP_CMPR 53 // CC = comparación de Rd con fuente (como COMP)
 
 // ==========================================
 // Estructuras de Datos
@@ -82,6 +124,8 @@ typedef struct
     unsigned int PC : 16;        // Program Counter (suficiente para 2000 posiciones)
 } PSW_t;
 
+#define NUM_GPR 8 // Registros de propósito general R0-R7
+
 // Contexto de Registros de CPU
 typedef struct
 {
@@ -93,6 +137,11 @@ typedef struct
     Word RL;   // Registro Límite
     Word RX;   // Registro Auxiliar/Indice
     Word SP;   // Stack Pointer
+    Word SB;   // Base física del segmento compartido
+    Word SL;   // Tamaño del segmento compartido (0 = sin segmento)
+    Word BLK;  // Palabras ya procesadas por una instrucción de bloque interrumpida
+    long long BLKSUM; // Suma parcial de un BSUM interrumpido (sin saturar)
+    Word R[NUM_GPR]; // Registros de propósito general
     PSW_t PSW; // Estado del sistema
 } CPU_Context;
 
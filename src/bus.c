@@ -52,6 +52,51 @@ int bus_write(int address, Word data, int client_id)
     return result;
 }
 
+int bus_rmw(int address, BusRmwFn fn, void *arg, Word *old, int client_id)
+{
+    // 1. Arbitraje: el bus se retiene durante toda la operacion
+    pthread_mutex_lock(&bus_lock);
+
+    // 2. Leer, calcular y (si corresponde) escribir sin soltar el bus
+    int result = mem_read_physical(address, old);
+    if (result == 0)
+    {
+        Word new_value = *old;
+        result = fn(*old, &new_value, arg);
+        if (result == 1 && mem_write_physical(address, new_value) != 0)
+            result = -1;
+    }
+
+    // 3. Liberar
+    pthread_mutex_unlock(&bus_lock);
+    return result;
+}
+
+int bus_block(BusBlockFn fn, void *arg, int first, int count, int client_id)
+{
+    // 1. Arbitraje: un solo lock para todo el bloque
+    pthread_mutex_lock(&bus_lock);
+
+    // 2. Una palabra por paso; el cliente puede cortar (ej. interrupcion pendiente)
+    int done = 0;
+    while (done < count)
+    {
+        int step = fn(first + done, arg);
+        if (step < 0)
+        {
+            done = -1;
+            break;
+        }
+        done++;
+        if (step == 1)
+            break;
+    }
+
+    // 3. Liberar
+    pthread_mutex_unlock(&bus_lock);
+    return done;
+}
+
 void bus_destroy() 
 {
     // Verificar errores que pueda arrojar esta funcion de abajo
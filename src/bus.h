@@ -13,4 +13,23 @@ void bus_destroy();
 int bus_read(int address, Word *data, int client_id);
 int bus_write(int address, Word data, int client_id);
 
+// Operacion de lectura-modificacion-escritura sobre una palabra.
+// Recibe el valor actual y decide el nuevo: retorna 1 para escribirlo,
+// 0 para dejar la memoria intacta (ej. CAS fallido).
+typedef int (*BusRmwFn)(Word old_value, Word *new_value, void *arg);
+
+// Ejecuta fn como UNA sola transaccion de bus: nadie (CPU, DMA, cargador)
+// puede tocar la memoria entre la lectura y la escritura.
+// Deja en *old el valor previo. Retorna el resultado de fn, o -1 si falla la memoria.
+int bus_rmw(int address, BusRmwFn fn, void *arg, Word *old, int client_id);
+
+// Paso de una operacion de bloque: procesa la palabra 'index' (el bus ya
+// esta tomado, se accede directo con mem_read/write_physical).
+// Retorna 0 para seguir, 1 para detenerse tras esta palabra, -1 si hay error.
+typedef int (*BusBlockFn)(int index, void *arg);
+
+// Recorre los indices [first, first+count) en UNA sola transaccion de bus.
+// Retorna cuantas palabras se procesaron, o -1 si fn reporta error.
+int bus_block(BusBlockFn fn, void *arg, int first, int count, int client_id);
+
 #endif
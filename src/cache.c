@@ -0,0 +1,559 @@
+#include "cache.h"
+#include "log.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Buffer cache entre el loader/DMA y disk.c
+ *  - Cada bloque guarda un sector, identificado por su número lineal (LBA)
+ *  - Búsqueda con tabla hash encadenada, reemplazo LRU con lista doble
+ *  - Las escrituras quedan sucias en el cache hasta cache_sync, un desalojo o el apagado
+ *  - Lectura anticipada: si un cliente lee sectores consecutivos, un hilo auxiliar
+ *    pide los siguientes CACHE_READAHEAD al disco mientras el cliente sigue trabajando
+ */
+
+#define NO_BLOCK -1
+
+typedef struct
+{
+    int lba;                 // Sector que contiene (NO_BLOCK si está libre)
+    int dirty;               // 1 si difiere del disco
+    int loading;             // 1 mientras la lectura del disco está en curso
+    int prefetched;          // 1 si lo trajo la lectura anticipada y nadie lo ha usado
+    char data[SECTOR_BYTES];
+    int prev, next;          // Lista LRU (prev = más reciente)
+    int hash_next;           // Siguiente bloque en la misma cubeta
+} CacheBlock;
+
+// Detección de acceso secuencial por cliente
+typedef struct
+{
+    int last_lba; // Último sector leído
+    int ra_next;  // Primer sector que aún no se ha pedido por adelantado
+} CacheStream;
+
+// Ventana de lectura anticipada pendiente para el hilo auxiliar
+typedef struct
+{
+    int start;
+    int count;
+} ReadAheadJob;
+
+static CacheBlock blocks[CACHE_BLOCKS];
+static int buckets[CACHE_BUCKETS];
+static int lru_head = NO_BLOCK; // Más recientemente usado
+static int lru_tail = NO_BLOCK; // Candidato a desalojo
+static CacheStats stats;
+static pthread_mutex_t cache_lock;
+static pthread_cond_t loaded_cv; // Algún bloque terminó de cargarse
+static int cache_ready = 0;
+
+static CacheStream streams[CACHE_STREAMS];
+static ReadAheadJob ra_jobs[CACHE_RA_JOBS];
+static int ra_head = 0, ra_count = 0;
+static pthread_cond_t ra_cv;
+static pthread_t ra_thread;
+static int ra_running = 0;
+
+static void lru_unlink(int b)
+{
+    if (blocks[b].prev != NO_BLOCK)
+        blocks[blocks[b].prev].next = blocks[b].next;
+    else
+        lru_head = blocks[b].next;
+
+    if (blocks[b].next != NO_BLOCK)
+        blocks[blocks[b].next].prev = blocks[b].prev;
+    else
+        lru_tail = blocks[b].prev;
+
+    blocks[b].prev = blocks[b].next = NO_BLOCK;
+}
+
+static void lru_push_front(int b)
+{
+    blocks[b].prev = NO_BLOCK;
+    blocks[b].next = lru_head;
+    if (lru_head != NO_BLOCK)
+        blocks[lru_head].prev = b;
+    lru_head = b;
+    if (lru_tail == NO_BLOCK)
+        lru_tail = b;
+}
+
+static void lru_touch(int b)
+{
+    lru_unlink(b);
+    lru_push_front(b);
+}
+
+static int hash_lookup(int lba)
+{
+    for (int b = buckets[lba % CACHE_BUCKETS]; b != NO_BLOCK; b = blocks[b].hash_next)
+    {
+        if (blocks[b].lba == lba)
+            return b;
+    }
+    return NO_BLOCK;
+}
+
+static void hash_remove(int b)
+{
+    int *link = &buckets[blocks[b].lba % CACHE_BUCKETS];
+    while (*link != NO_BLOCK && *link != b)
+        link = &blocks[*link].hash_next;
+    if (*link == b)
+        *link = blocks[b].hash_next;
+    blocks[b].hash_next = NO_BLOCK;
+}
+
+static void hash_insert(int b)
+{
+    int bucket = blocks[b].lba % CACHE_BUCKETS;
+    blocks[b].hash_next = buckets[bucket];
+    buckets[bucket] = b;
+}
+
+static void reset_blocks(void)
+{
+    for (int i = 0; i < CACHE_BUCKETS; i++)
+        buckets[i] = NO_BLOCK;
+
+    // Todos los bloques libres quedan en la lista LRU, listos para usarse
+    lru_head = lru_tail = NO_BLOCK;
+    for (int b = 0; b < CACHE_BLOCKS; b++)
+    {
+        blocks[b].lba = NO_BLOCK;
+        blocks[b].dirty = 0;
+        blocks[b].loading = 0;
+        blocks[b].prefetched = 0;
+        blocks[b].hash_next = NO_BLOCK;
+        blocks[b].prev = blocks[b].next = NO_BLOCK;
+        lru_push_front(b);
+    }
+    for (int i = 0; i < CACHE_STREAMS; i++)
+    {
+        streams[i].last_lba = NO_BLOCK;
+        streams[i].ra_next = NO_BLOCK;
+    }
+    stats.used = 0;
+    stats.dirty = 0;
+}
+
+/**
+ * Obtiene un bloque para un sector nuevo, desalojando el menos usado.
+ * Los bloques con lectura en curso no se desalojan.
+ * Si el desalojado está sucio se escribe al disco antes de reutilizarlo.
+ * Debe llamarse con cache_lock tomado.
+ */
+static int take_block(int lba)
+{
+    int b = lru_tail;
+    while (b != NO_BLOCK && blocks[b].loading)
+        b = blocks[b].prev;
+    if (b == NO_BLOCK)
+        return NO_BLOCK;
+
+    if (blocks[b].lba != NO_BLOCK)
+    {
+        if (blocks[b].dirty)
+        {
+            int t, c, s;
+            disk_from_lba(blocks[b].lba, &t, &c, &s);
+            if (disk_write_sector(t, c, s, blocks[b].data) != 0)
+            {
+                write_log(1, "CACHE: Fallo al escribir de vuelta el sector (%d,%d,%d)\n", t, c, s);
+            }
+            stats.writebacks++;
+            stats.dirty--;
+        }
+        hash_remove(b);
+        stats.evictions++;
+        stats.used--;
+    }
+
+    blocks[b].lba = lba;
+    blocks[b].dirty = 0;
+    blocks[b].loading = 0;
+    blocks[b].prefetched = 0;
+    hash_insert(b);
+    lru_touch(b);
+    stats.used++;
+    return b;
+}
+
+// Termina la carga de un bloque con los datos leídos del disco. Con cache_lock tomado
+static void finish_load(int lba, const char *data, int ok)
+{
+    int b = hash_lookup(lba);
+    // Si alguien lo sobrescribió mientras tanto (loading = 0) su versión es más nueva
+    if (b != NO_BLOCK && blocks[b].loading)
+    {
+        blocks[b].loading = 0;
+        if (ok)
+        {
+            memcpy(blocks[b].data, data, SECTOR_BYTES);
+        }
+        else
+        {
+            hash_remove(b);
+            blocks[b].lba = NO_BLOCK;
+            blocks[b].prefetched = 0;
+            stats.used--;
+        }
+    }
+    pthread_cond_broadcast(&loaded_cv);
+}
+
+/**
+ * Registra el acceso del cliente y, si es secuencial, encola una ventana
+ * de lectura anticipada para el hilo auxiliar. Con cache_lock tomado.
+ */
+static void note_access(int client_id, int lba)
+{
+    if (client_id < 0 || client_id >= CACHE_STREAMS)
+        return;
+
+    CacheStream *st = &streams[client_id];
+    int sequential = (st->last_lba != NO_BLOCK && lba == st->last_lba + 1);
+    st->last_lba = lba;
+
+    if (!sequential)
+    {
+        st->ra_next = NO_BLOCK;
+        return;
+    }
+
+    // Pedir la siguiente ventana cuando quede menos de media ventana por delante
+    if (st->ra_next == NO_BLOCK || st->ra_next <= lba)
+        st->ra_next = lba + 1;
+    if (st->ra_next - lba > CACHE_READAHEAD / 2)
+        return;
+
+    int start = st->ra_next;
+    int end = lba + 1 + CACHE_READAHEAD;
+    if (end > DISK_TOTAL_SECTORS)
+        end = DISK_TOTAL_SECTORS;
+    if (start >= end || ra_count == CACHE_RA_JOBS)
+        return;
+
+    ReadAheadJob *job = &ra_jobs[(ra_head + ra_count) % CACHE_RA_JOBS];
+    job->start = start;
+    job->count = end - start;
+    ra_count++;
+    st->ra_next = end;
+    pthread_cond_signal(&ra_cv);
+}
+
+// Hilo auxiliar: pide al disco las ventanas de lectura anticipada sin bloquear a los clientes
+static void *readahead_worker(void *arg)
+{
+    (void)arg;
+    DiskRequest requests[CACHE_READAHEAD];
+    char staging[CACHE_READAHEAD][SECTOR_BYTES]; // Buffer de preparación de la ventana
+
+    pthread_mutex_lock(&cache_lock);
+    while (1)
+    {
+        while (ra_count == 0 && ra_running)
+            pthread_cond_wait(&ra_cv, &cache_lock);
+        if (ra_count == 0 && !ra_running)
+            break;
+
+        ReadAheadJob job = ra_jobs[ra_head];
+        ra_head = (ra_head + 1) % CACHE_RA_JOBS;
+        ra_count--;
+
+        // Reservar bloques "en carga" para los sectores que no estén ya en el cache
+        int n = 0;
+        for (int lba = job.start; lba < job.start + job.count && n < CACHE_READAHEAD; lba++)
+        {
+            if (hash_lookup(lba) != NO_BLOCK)
+                continue;
+            int b = take_block(lba);
+            if (b == NO_BLOCK)
+                break;
+            blocks[b].loading = 1;
+            blocks[b].prefetched = 1;
+            DiskRequest *req = &requests[n];
+            memset(req, 0, sizeof(*req));
+            disk_from_lba(lba, &req->track, &req->cylinder, &req->sector);
+            req->buf = staging[n];
+            n++;
+        }
+        stats.readahead += n;
+        pthread_mutex_unlock(&cache_lock);
+
+        // Encolar toda la ventana junta: el disco la atiende con su política
+        int submitted[CACHE_READAHEAD];
+        for (int i = 0; i < n; i++)
+            submitted[i] = (disk_submit(&requests[i]) == 0);
+
+        for (int i = 0; i < n; i++)
+        {
+            int ok = submitted[i] && disk_wait(&requests[i]) == 0;
+            pthread_mutex_lock(&cache_lock);
+            finish_load(disk_to_lba(requests[i].track, requests[i].cylinder, requests[i].sector),
+                        staging[i], ok);
+            pthread_mutex_unlock(&cache_lock);
+        }
+
+        pthread_mutex_lock(&cache_lock);
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return NULL;
+}
+
+int cache_init(void)
+{
+    if (pthread_mutex_init(&cache_lock, NULL) != 0)
+    {
+        write_log(1, "CACHE: Error al inicializar el mutex del cache\n");
+        return -1;
+    }
+    pthread_cond_init(&loaded_cv, NULL);
+    pthread_cond_init(&ra_cv, NULL);
+    memset(&stats, 0, sizeof(stats));
+    reset_blocks();
+    ra_head = ra_count = 0;
+
+    ra_running = 1;
+    if (pthread_create(&ra_thread, NULL, readahead_worker, NULL) != 0)
+    {
+        // Sin hilo auxiliar el cache funciona igual, sólo que sin lectura anticipada
+        write_log(1, "CACHE: No se pudo crear el hilo de lectura anticipada\n");
+        ra_running = 0;
+    }
+
+    cache_ready = 1;
+    write_log(0, "CACHE: Buffer cache inicializado (%d bloques, lectura anticipada de %d)\n",
+              CACHE_BLOCKS, CACHE_READAHEAD);
+    return 0;
+}
+
+int cache_read_sector(int track, int cylinder, int sector, char *out_buf, int client_id)
+{
+    if (!cache_ready)
+        return disk_read_sector(track, cylinder, sector, out_buf);
+
+    if (track < 0 || track >= DISK_TRACKS ||
+        cylinder < 0 || cylinder >= DISK_CYLINDERS ||
+        sector < 0 || sector >= DISK_SECTORS || out_buf == NULL)
+    {
+        return -1;
+    }
+
+    int lba = disk_to_lba(track, cylinder, sector);
+
+    pthread_mutex_lock(&cache_lock);
+    note_access(client_id, lba);
+
+    int b = hash_lookup(lba);
+    if (b != NO_BLOCK)
+    {
+        // Acierto: sin latencia de disco (o sólo lo que falte de una lectura anticipada)
+        stats.hits++;
+        if (blocks[b].prefetched)
+        {
+            stats.ra_hits++;
+            blocks[b].prefetched = 0;
+        }
+        while ((b = hash_lookup(lba)) != NO_BLOCK && blocks[b].loading)
+            pthread_cond_wait(&loaded_cv, &cache_lock);
+    }
+    else
+    {
+        stats.misses++;
+    }
+
+    if (b == NO_BLOCK)
+    {
+        // Fallo: reservar el bloque "en carga" y leer el disco sin bloquear el cache
+        b = take_block(lba);
+        if (b == NO_BLOCK)
+        {
+            pthread_mutex_unlock(&cache_lock);
+            return disk_read_sector(track, cylinder, sector, out_buf);
+        }
+        blocks[b].loading = 1;
+        pthread_mutex_unlock(&cache_lock);
+
+        char data[SECTOR_BYTES];
+        int ok = (disk_read_sector(track, cylinder, sector, data) == 0);
+
+        pthread_mutex_lock(&cache_lock);
+        finish_load(lba, data, ok);
+        if (!ok)
+        {
+            pthread_mutex_unlock(&cache_lock);
+            return -1;
+        }
+        b = hash_lookup(lba);
+        if (b == NO_BLOCK)
+        {
+            // El cache se descartó mientras se leía: se entrega lo leído
+            memcpy(out_buf, data, SECTOR_BYTES);
+            pthread_mutex_unlock(&cache_lock);
+            return 0;
+        }
+    }
+
+    memcpy(out_buf, blocks[b].data, SECTOR_BYTES);
+    lru_touch(b);
+    pthread_mutex_unlock(&cache_lock);
+    return 0;
+}
+
+int cache_write_sector(int track, int cylinder, int sector, const char *in_buf)
+{
+    if (!cache_ready)
+        return disk_write_sector(track, cylinder, sector, in_buf);
+
+    if (track < 0 || track >= DISK_TRACKS ||
+        cylinder < 0 || cylinder >= DISK_CYLINDERS ||
+        sector < 0 || sector >= DISK_SECTORS || in_buf == NULL)
+    {
+        return -1;
+    }
+
+    int lba = disk_to_lba(track, cylinder, sector);
+
+    pthread_mutex_lock(&cache_lock);
+    int b = hash_lookup(lba);
+    if (b != NO_BLOCK)
+    {
+        stats.hits++;
+        lru_touch(b);
+    }
+    else
+    {
+        // Se sobrescribe el sector completo: no hace falta leerlo del disco
+        stats.misses++;
+        b = take_block(lba);
+        if (b == NO_BLOCK)
+        {
+            pthread_mutex_unlock(&cache_lock);
+            return disk_write_sector(track, cylinder, sector, in_buf);
+        }
+    }
+
+    memcpy(blocks[b].data, in_buf, SECTOR_BYTES);
+    if (blocks[b].loading)
+    {
+        // La lectura en curso traerá datos viejos: esta escritura gana
+        blocks[b].loading = 0;
+        pthread_cond_broadcast(&loaded_cv);
+    }
+    blocks[b].prefetched = 0;
+    if (!blocks[b].dirty)
+    {
+        blocks[b].dirty = 1;
+        stats.dirty++;
+    }
+    pthread_mutex_unlock(&cache_lock);
+    return 0;
+}
+
+int cache_sync(void)
+{
+    if (!cache_ready)
+        return 0;
+
+    pthread_mutex_lock(&cache_lock);
+    if (stats.dirty == 0)
+    {
+        pthread_mutex_unlock(&cache_lock);
+        return 0;
+    }
+
+    // Se encolan todos los sucios a la vez para que el disco los ordene
+    DiskRequest *requests = (DiskRequest *)calloc(stats.dirty, sizeof(DiskRequest));
+    int *owners = (int *)calloc(stats.dirty, sizeof(int));
+    if (!requests || !owners)
+    {
+        write_log(1, "CACHE: Sin memoria para sincronizar\n");
+        free(requests);
+        free(owners);
+        pthread_mutex_unlock(&cache_lock);
+        return -1;
+    }
+
+    int n = 0;
+    for (int b = 0; b < CACHE_BLOCKS && n < stats.dirty; b++)
+    {
+        if (blocks[b].lba == NO_BLOCK || !blocks[b].dirty)
+            continue;
+        DiskRequest *req = &requests[n];
+        disk_from_lba(blocks[b].lba, &req->track, &req->cylinder, &req->sector);
+        req->write = 1;
+        req->buf = blocks[b].data;
+        if (disk_submit(req) == 0)
+            owners[n++] = b;
+    }
+
+    int status = 0;
+    for (int i = 0; i < n; i++)
+    {
+        if (disk_wait(&requests[i]) != 0)
+        {
+            status = -1;
+            continue;
+        }
+        blocks[owners[i]].dirty = 0;
+        stats.dirty--;
+        stats.writebacks++;
+    }
+    pthread_mutex_unlock(&cache_lock);
+
+    free(requests);
+    free(owners);
+    write_log(0, "CACHE: Sincronizados %d sector(es) sucios\n", n);
+    return status;
+}
+
+void cache_invalidate(void)
+{
+    if (!cache_ready)
+        return;
+    pthread_mutex_lock(&cache_lock);
+    reset_blocks();
+    pthread_cond_broadcast(&loaded_cv);
+    pthread_mutex_unlock(&cache_lock);
+    write_log(0, "CACHE: Contenido descartado\n");
+}
+
+void cache_get_stats(CacheStats *out)
+{
+    if (!cache_ready)
+    {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    pthread_mutex_lock(&cache_lock);
+    *out = stats;
+    pthread_mutex_unlock(&cache_lock);
+}
+
+void cache_destroy(void)
+{
+    if (!cache_ready)
+        return;
+
+    // Terminar las lecturas anticipadas pendientes antes de sincronizar
+    if (ra_running)
+    {
+        pthread_mutex_lock(&cache_lock);
+        ra_running = 0;
+        pthread_cond_broadcast(&ra_cv);
+        pthread_mutex_unlock(&cache_lock);
+        pthread_join(ra_thread, NULL);
+    }
+
+    cache_sync();
+    cache_ready = 0;
+    pthread_cond_destroy(&ra_cv);
+    pthread_cond_destroy(&loaded_cv);
+    pthread_mutex_destroy(&cache_lock);
+    write_log(0, "CACHE: finalizado exitosamente\n");
+}
@@ -0,0 +1,48 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "disk.h"
+
+#define CACHE_BLOCKS 256  // Sectores que caben en el buffer cache
+#define CACHE_BUCKETS 512 // Cubetas de la tabla hash (por número lineal de sector)
+#define CACHE_READAHEAD 8 // Sectores que se piden por adelantado al detectar acceso secuencial
+#define CACHE_STREAMS 4   // Clientes con detección de secuencia propia (igual que client_id del bus)
+#define CACHE_RA_JOBS 16  // Ventanas de lectura anticipada pendientes
+
+// Contadores del buffer cache
+typedef struct
+{
+    long hits;       // Lecturas/escrituras atendidas sin ir al disco
+    long misses;     // Accesos que tuvieron que leer el disco
+    long evictions;  // Bloques desalojados por LRU
+    long writebacks; // Sectores sucios escritos de vuelta al disco
+    long readahead;  // Sectores pedidos por adelantado
+    long ra_hits;    // Accesos servidos por un sector traído por adelantado
+    int used;        // Bloques ocupados
+    int dirty;       // Bloques modificados pendientes de escribir
+} CacheStats;
+
+// Inicializa el buffer cache (vacío). Devuelve 0 ok, -1 error
+int cache_init(void);
+
+// Escribe los bloques sucios al disco y elimina el cache
+void cache_destroy(void);
+
+// Lee un sector a través del cache (si no está, lo trae del disco).
+// client_id identifica el flujo para detectar lecturas secuenciales (1=DMA, 3=Loader)
+// y pedir por adelantado los siguientes sectores sin bloquear al cliente
+int cache_read_sector(int track, int cylinder, int sector, char *out_buf, int client_id);
+
+// Escribe un sector en el cache y lo marca sucio (write-back)
+int cache_write_sector(int track, int cylinder, int sector, const char *in_buf);
+
+// Escribe al disco todos los bloques sucios (en un solo lote). Devuelve 0 ok, -1 error
+int cache_sync(void);
+
+// Descarta todo el contenido sin escribirlo (el disco fue formateado)
+void cache_invalidate(void);
+
+// Copia los contadores actuales
+void cache_get_stats(CacheStats *out);
+
+#endif // CACHE_H
@@ -0,0 +1,434 @@
+#include "console.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// Cola circular de líneas leídas de stdin
+static char lines[CONSOLE_QUEUE_LINES][CONSOLE_LINE_MAX];
+static int q_head = 0;
+static int q_count = 0;
+static int stdin_closed = 0; // El hilo lector llegó a EOF
+
+static pthread_mutex_t console_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t line_ready = PTHREAD_COND_INITIALIZER; // Hay una línea nueva o EOF
+static pthread_cond_t slot_free = PTHREAD_COND_INITIALIZER;  // Se liberó lugar en la cola
+
+static pthread_t reader_thread;
+static int reader_running = 0;
+
+// Archivo de entrada para los procesos (NULL = consola)
+static FILE *input_file = NULL;
+
+// Hilo lector: pasa stdin a la cola línea por línea
+static void *console_reader(void *arg)
+{
+    (void)arg;
+    char buf[CONSOLE_LINE_MAX];
+
+    while (fgets(buf, sizeof(buf), stdin) != NULL)
+    {
+        buf[strcspn(buf, "\n")] = '\0'; // Elimina salto de línea
+
+        pthread_mutex_lock(&console_lock);
+        while (q_count == CONSOLE_QUEUE_LINES)
+            pthread_cond_wait(&slot_free, &console_lock);
+
+        int tail = (q_head + q_count) % CONSOLE_QUEUE_LINES;
+        memcpy(lines[tail], buf, sizeof(buf));
+        q_count++;
+        pthread_cond_broadcast(&line_ready);
+        pthread_mutex_unlock(&console_lock);
+    }
+
+    pthread_mutex_lock(&console_lock);
+    stdin_closed = 1;
+    pthread_cond_broadcast(&line_ready);
+    pthread_mutex_unlock(&console_lock);
+    return NULL;
+}
+
+int console_init()
+{
+    if (reader_running)
+        return 0;
+
+    if (pthread_create(&reader_thread, NULL, console_reader, NULL) != 0)
+    {
+        write_log(1, "CONSOLA: No se pudo crear el hilo lector.\n");
+        return -1;
+    }
+    reader_running = 1;
+    write_log(0, "CONSOLA: Hilo lector de entrada iniciado.\n");
+    return 0;
+}
+
+void console_destroy()
+{
+    if (reader_running)
+    {
+        // El lector puede estar bloqueado en fgets esperando al teclado
+        pthread_cancel(reader_thread);
+        pthread_join(reader_thread, NULL);
+        reader_running = 0;
+    }
+    if (input_file != NULL)
+    {
+        fclose(input_file);
+        input_file = NULL;
+    }
+}
+
+// Saca la primera línea de la cola. Se llama con console_lock tomado y q_count > 0
+static void pop_line(char *buf, size_t size)
+{
+    strncpy(buf, lines[q_head], size - 1);
+    buf[size - 1] = '\0';
+    q_head = (q_head + 1) % CONSOLE_QUEUE_LINES;
+    q_count--;
+    pthread_cond_signal(&slot_free);
+}
+
+int console_read_line(char *buf, size_t size)
+{
+    pthread_mutex_lock(&console_lock);
+    while (q_count == 0 && !stdin_closed)
+        pthread_cond_wait(&line_ready, &console_lock);
+
+    int result = -1;
+    if (q_count > 0)
+    {
+        pop_line(buf, size);
+        result = 0;
+    }
+    pthread_mutex_unlock(&console_lock);
+    return result;
+}
+
+int console_try_read_input(char *buf, size_t size)
+{
+    // Primero el archivo de entrada, si hay uno
+    if (input_file != NULL)
+    {
+        if (fgets(buf, (int)size, input_file) != NULL)
+        {
+            buf[strcspn(buf, "\n")] = '\0';
+            return 1;
+        }
+        write_log(0, "CONSOLA: Fin del archivo de entrada. Se vuelve a leer de la consola.\n");
+        fclose(input_file);
+        input_file = NULL;
+    }
+
+    pthread_mutex_lock(&console_lock);
+    int result = 0;
+    if (q_count > 0)
+    {
+        pop_line(buf, size);
+        result = 1;
+    }
+    else if (stdin_closed)
+    {
+        result = -1;
+    }
+    pthread_mutex_unlock(&console_lock);
+    return result;
+}
+
+int console_input_ready()
+{
+    if (input_file != NULL)
+        return 1;
+
+    pthread_mutex_lock(&console_lock);
+    int ready = q_count > 0 || stdin_closed;
+    pthread_mutex_unlock(&console_lock);
+    return ready;
+}
+
+int console_set_input_file(const char *path)
+{
+    if (input_file != NULL)
+    {
+        fclose(input_file);
+        input_file = NULL;
+    }
+    if (path == NULL)
+        return 0;
+
+    input_file = fopen(path, "r");
+    if (input_file == NULL)
+    {
+        write_log(1, "CONSOLA: No se pudo abrir el archivo de entrada %s\n", path);
+        return -1;
+    }
+    write_log(0, "CONSOLA: Entrada de los procesos desde %s\n", path);
+    return 0;
+}
+
+// ============================================================
+// === SALIDA DE LOS PROCESOS ===
+// ============================================================
+//
+// Sólo la usa el hilo de la CPU (syscall 2, reloj, terminación) y el shell, que es el mismo hilo:
+// no hace falta exclusión mutua.
+
+typedef struct
+{
+    char data[CONSOLE_OUT_BUFFER];
+    int len;        // Bytes pendientes
+    int lines;      // Líneas pendientes
+    int since_tick; // Tic en que quedó la primera línea pendiente
+    int dirty;      // Está en la lista de pendientes
+    FILE *file;     // Archivo de salida (NULL = consola)
+} OutBuffer;
+
+typedef struct
+{
+    char program[50];
+    char path[256];
+} OutRedirect;
+
+static OutBuffer **out_buffers = NULL; // Indexado por PID, crece según haga falta
+static int out_capacity = 0;
+
+static int *dirty_pids = NULL; // Procesos con salida pendiente (para el reloj)
+static int dirty_count = 0;
+static int dirty_capacity = 0;
+
+static OutRedirect redirects[CONSOLE_MAX_REDIRECTS];
+static int redirect_count = 0;
+
+static int current_tick = 0;
+static ConsoleOutputStats out_stats;
+static struct timespec first_value_time, last_value_time;
+
+static double elapsed_seconds(const struct timespec *from, const struct timespec *to)
+{
+    return (double)(to->tv_sec - from->tv_sec) + (double)(to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+// Devuelve el buffer del proceso, creándolo si no existe
+static OutBuffer *get_out_buffer(int pid)
+{
+    if (pid < 0)
+        return NULL;
+
+    if (pid >= out_capacity)
+    {
+        int new_capacity = out_capacity > 0 ? out_capacity : 32;
+        while (new_capacity <= pid)
+            new_capacity *= 2;
+
+        OutBuffer **grown = realloc(out_buffers, new_capacity * sizeof(OutBuffer *));
+        if (grown == NULL)
+            return NULL;
+        memset(grown + out_capacity, 0, (new_capacity - out_capacity) * sizeof(OutBuffer *));
+        out_buffers = grown;
+        out_capacity = new_capacity;
+    }
+
+    if (out_buffers[pid] == NULL)
+        out_buffers[pid] = calloc(1, sizeof(OutBuffer));
+    return out_buffers[pid];
+}
+
+// Saca un PID de la lista de pendientes (el orden no importa)
+static void undirty(int pid)
+{
+    for (int i = 0; i < dirty_count; i++)
+    {
+        if (dirty_pids[i] == pid)
+        {
+            dirty_pids[i] = dirty_pids[--dirty_count];
+            return;
+        }
+    }
+}
+
+// Escribe de una vez lo pendiente del proceso
+static void flush_buffer(int pid, OutBuffer *out)
+{
+    if (out->len > 0)
+    {
+        FILE *dst = out->file != NULL ? out->file : stdout;
+        fwrite(out->data, 1, out->len, dst);
+        fflush(dst);
+        out_stats.bytes += out->len;
+        out_stats.flushes++;
+        out->len = 0;
+        out->lines = 0;
+    }
+    if (out->dirty)
+    {
+        out->dirty = 0;
+        undirty(pid);
+    }
+}
+
+void console_output_open(int pid, const char *program_name)
+{
+    OutBuffer *out = get_out_buffer(pid);
+    if (out == NULL)
+        return;
+
+    // El PID puede ser reutilizado: no debería quedar nada del dueño anterior
+    flush_buffer(pid, out);
+    if (out->file != NULL)
+    {
+        fclose(out->file);
+        out->file = NULL;
+    }
+
+    for (int i = 0; i < redirect_count; i++)
+    {
+        if (strcmp(redirects[i].program, program_name) != 0)
+            continue;
+
+        out->file = fopen(redirects[i].path, "a");
+        if (out->file == NULL)
+            write_log(1, "CONSOLA: No se pudo abrir %s. La salida del proceso %d va a la consola.\n",
+                      redirects[i].path, pid);
+        else
+            write_log(0, "CONSOLA: Salida del proceso %d (%s) -> %s\n", pid, program_name, redirects[i].path);
+        break;
+    }
+}
+
+void console_output_value(int pid, int value)
+{
+    OutBuffer *out = get_out_buffer(pid);
+    if (out == NULL)
+    {
+        // Sin memoria para el buffer: se escribe directo
+        printf("\n[PROCESO %d]> %d\n", pid, value);
+        return;
+    }
+
+    char line[64];
+    int n = out->file != NULL ? snprintf(line, sizeof(line), "%d\n", value)
+                              : snprintf(line, sizeof(line), "\n[PROCESO %d]> %d\n", pid, value);
+
+    if (out->len + n > CONSOLE_OUT_BUFFER)
+        flush_buffer(pid, out);
+
+    memcpy(out->data + out->len, line, n);
+    out->len += n;
+    out->lines++;
+
+    clock_gettime(CLOCK_MONOTONIC, &last_value_time);
+    if (out_stats.values++ == 0)
+        first_value_time = last_value_time;
+
+    if (out->lines >= CONSOLE_FLUSH_LINES)
+    {
+        flush_buffer(pid, out);
+        return;
+    }
+
+    if (!out->dirty)
+    {
+        if (dirty_count == dirty_capacity)
+        {
+            int new_capacity = dirty_capacity > 0 ? dirty_capacity * 2 : 32;
+            int *grown = realloc(dirty_pids, new_capacity * sizeof(int));
+            if (grown == NULL)
+            {
+                flush_buffer(pid, out); // No se puede esperar al reloj
+                return;
+            }
+            dirty_pids = grown;
+            dirty_capacity = new_capacity;
+        }
+        dirty_pids[dirty_count++] = pid;
+        out->dirty = 1;
+        out->since_tick = current_tick;
+    }
+}
+
+void console_output_close(int pid)
+{
+    if (pid < 0 || pid >= out_capacity || out_buffers[pid] == NULL)
+        return;
+
+    OutBuffer *out = out_buffers[pid];
+    flush_buffer(pid, out);
+    if (out->file != NULL)
+    {
+        fclose(out->file);
+        out->file = NULL;
+    }
+}
+
+void console_output_flush_all()
+{
+    // flush_buffer saca al proceso de la lista
+    while (dirty_count > 0)
+    {
+        int pid = dirty_pids[dirty_count - 1];
+        flush_buffer(pid, out_buffers[pid]);
+    }
+}
+
+void console_output_tick(int ticks)
+{
+    current_tick = ticks;
+    for (int i = 0; i < dirty_count;)
+    {
+        int pid = dirty_pids[i];
+        if (ticks - out_buffers[pid]->since_tick >= CONSOLE_FLUSH_TICKS)
+            flush_buffer(pid, out_buffers[pid]); // Ocupa su lugar el último de la lista
+        else
+            i++;
+    }
+}
+
+int console_set_output_file(const char *program_name, const char *path)
+{
+    for (int i = 0; i < redirect_count; i++)
+    {
+        if (strcmp(redirects[i].program, program_name) != 0)
+            continue;
+
+        if (path == NULL)
+            redirects[i] = redirects[--redirect_count];
+        else
+        {
+            strncpy(redirects[i].path, path, sizeof(redirects[i].path) - 1);
+            redirects[i].path[sizeof(redirects[i].path) - 1] = '\0';
+        }
+        return 0;
+    }
+
+    if (path == NULL)
+        return 0;
+    if (redirect_count == CONSOLE_MAX_REDIRECTS)
+        return -1;
+
+    OutRedirect *r = &redirects[redirect_count++];
+    strncpy(r->program, program_name, sizeof(r->program) - 1);
+    r->program[sizeof(r->program) - 1] = '\0';
+    strncpy(r->path, path, sizeof(r->path) - 1);
+    r->path[sizeof(r->path) - 1] = '\0';
+    return 0;
+}
+
+void console_print_redirects()
+{
+    if (redirect_count == 0)
+    {
+        printf("La salida de todos los programas va a la consola.\n");
+        return;
+    }
+    for (int i = 0; i < redirect_count; i++)
+        printf(" %-30s -> %s\n", redirects[i].program, redirects[i].path);
+}
+
+void console_get_output_stats(ConsoleOutputStats *stats)
+{
+    *stats = out_stats;
+    double secs = elapsed_seconds(&first_value_time, &last_value_time);
+    stats->rate = secs > 0 ? out_stats.values / secs : 0.0;
+}
@@ -0,0 +1,94 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stddef.h>
+
+// --- CONSOLA (ENTRADA) ---
+// Un hilo lector es el único dueño de stdin: lee líneas y las deja en una cola.
+// De esa cola leen el prompt del shell y la syscall 3, sin que el kernel se bloquee esperando al teclado.
+#define CONSOLE_QUEUE_LINES 64 // Líneas que pueden esperar en la cola
+#define CONSOLE_LINE_MAX 256   // Largo máximo de una línea (incluye '\0')
+
+// Inicia el hilo lector de stdin
+int console_init();
+
+// Detiene el hilo lector (sólo al apagar)
+void console_destroy();
+
+/**
+ * Lee la siguiente línea para el SHELL, esperando si no hay ninguna.
+ * La línea llega sin el '\n' final.
+ *
+ * Retorna: 0 si leyó una línea, -1 si stdin se cerró y la cola está vacía
+ */
+int console_read_line(char *buf, size_t size);
+
+/**
+ * Lee una línea de ENTRADA para los procesos (syscall 3) SIN ESPERAR.
+ * Si hay un archivo de entrada (ver console_set_input_file) se lee primero de él;
+ * cuando se acaba se vuelve a la consola.
+ *
+ * Retorna: 1 si leyó una línea, 0 si todavía no hay, -1 si no va a haber más (fin de entrada)
+ */
+int console_try_read_input(char *buf, size_t size);
+
+// Indica si console_try_read_input tiene algo que entregar (línea o fin de entrada)
+int console_input_ready();
+
+/**
+ * Usa un archivo de la PC real como entrada de los procesos (NULL vuelve a la consola).
+ *
+ * Retorna: 0 si éxito, -1 si no se pudo abrir
+ */
+int console_set_input_file(const char *path);
+
+// --- CONSOLA (SALIDA) ---
+// Lo que imprime cada proceso (syscall 2) se junta en un buffer propio y se escribe de a tandas:
+// al llegar a CONSOLE_FLUSH_LINES líneas, al terminar el proceso o cada CONSOLE_FLUSH_TICKS tics.
+// La salida de un programa se puede redirigir a un archivo de la PC real (ver console_set_output_file).
+#define CONSOLE_OUT_BUFFER 1024 // Bytes del buffer de salida de cada proceso
+#define CONSOLE_FLUSH_LINES 16  // Líneas acumuladas que fuerzan una escritura
+#define CONSOLE_FLUSH_TICKS 25  // Tics de reloj que puede esperar una salida pendiente
+#define CONSOLE_MAX_REDIRECTS 16
+
+// Estadísticas de la salida de los procesos
+typedef struct
+{
+    long values;  // Valores impresos por la syscall 2
+    long bytes;   // Bytes escritos (consola y archivos)
+    long flushes; // Escrituras reales (tandas)
+    double rate;  // Valores por segundo entre el primero y el último
+} ConsoleOutputStats;
+
+/**
+ * Prepara la salida de un proceso recién creado.
+ * Si hay una redirección para su programa, abre el archivo.
+ */
+void console_output_open(int pid, const char *program_name);
+
+// Agrega un valor impreso por el proceso a su buffer (puede provocar una escritura)
+void console_output_value(int pid, int value);
+
+// Escribe lo pendiente del proceso y cierra su archivo de salida (al terminar)
+void console_output_close(int pid);
+
+// Escribe lo pendiente de todos los procesos (antes de un prompt o de un listado)
+void console_output_flush_all();
+
+// Llamada en cada tic de reloj: escribe las salidas que esperaron demasiado
+void console_output_tick(int ticks);
+
+/**
+ * Redirige la salida de un programa a un archivo (NULL vuelve a la consola).
+ * Se aplica a los procesos que se creen a partir de ahora.
+ *
+ * Retorna: 0 si éxito, -1 si no hay lugar para otra redirección
+ */
+int console_set_output_file(const char *program_name, const char *path);
+
+// Muestra las redirecciones configuradas
+void console_print_redirects();
+
+void console_get_output_stats(ConsoleOutputStats *stats);
+
+#endif // CONSOLE_H
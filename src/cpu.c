@@ -8,12 +8,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <string.h>
+#include <time.h>
 
+// Registros de la CPU. Mientras un proceso corre, ESTE es su contexto:
+// el PCB sólo se actualiza cuando el proceso sale de la CPU (ver dispatch)
 CPU_Context context;
 // Variables para gestión de interrupciones
 static int interrupt_pending = 0;  // Bandera: 0=No, 1=Si
 static int interrupt_code_val = 0; // Cuál interrupción es
 
+// Modo e interrupciones del proceso al entrar a la interrupción en curso
+static int irq_saved_mode = USER_MODE;
+static int irq_saved_interrupts = 1;
+
+static CtxSwitchStats switch_stats;
+
+static long long now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
 // Guarda un valor en la Pila del Sistema
 // Retorna 0 si éxito, -1 si desbordamiento (Stack Overflow)
 // Guarda un valor en la Pila del Sistema o del Usuario
@@ -22,7 +39,7 @@ int push_stack(int value)
     context.SP--;
 
     // El límite para no desbordar depende de si es Kernel o Usuario
-    int stack_limit = (context.PSW.Mode == USER_MODE) ? context.RB : 30;
+    int stack_limit = (context.PSW.Mode == USER_MODE) ? context.RB : KERNEL_STACK_LIMIT;
 
     if (context.SP < stack_limit)
     {
@@ -42,7 +59,7 @@ int push_stack(int value)
 int pop_stack(int *value)
 {
     // la base de la pila depende del modo
-    int stack_base = (context.PSW.Mode == USER_MODE) ? context.RL : 299;
+    int stack_base = (context.PSW.Mode == USER_MODE) ? context.RL : SYSTEM_STACK_BASE;
 
     if (context.SP >= stack_base)
     {
@@ -101,6 +118,12 @@ int mmu_translate(int logical_addr)
         return logical_addr; // Modo privilegiado accede a todo
     }
 
+    // Segmento compartido adjuntado (SHM): se ve a partir de SHM_LOGICAL_BASE
+    if (context.SL > 0 && logical_addr >= SHM_LOGICAL_BASE && logical_addr < SHM_LOGICAL_BASE + context.SL)
+    {
+        return context.SB + (logical_addr - SHM_LOGICAL_BASE);
+    }
+
     // Modo Usuario: se Reubica
     int physical_addr = logical_addr + context.RB;
 
@@ -136,7 +159,12 @@ void cpu_init()
     context.RB = 0;
     context.RL = 0;
     context.RX = 0;
-    context.SP = 299; // limite memoria del SO, aqui inicia la PILA
+    context.SP = SYSTEM_STACK_BASE; // limite memoria del SO, aqui inicia la PILA
+    context.SB = 0;
+    context.SL = 0;
+    context.BLK = 0;
+    context.BLKSUM = 0;
+    memset(context.R, 0, sizeof(context.R));
 
     // inicializar PSW
     context.PSW.CC = 0;
@@ -147,23 +175,56 @@ void cpu_init()
     // Limpiar banderas de interrupción antiguas ---
     interrupt_pending = 0;
     interrupt_code_val = 0;
+    memset(&switch_stats, 0, sizeof(switch_stats));
 
     write_log(0, "CPU Inicializada.\n");
 }
 
+/**
+ * Cambia el proceso que ocupa la CPU (nuevo_pid = NULL_PID deja la CPU libre).
+ * Es el único lugar donde se copian contextos: se salva el del que sale
+ * y se carga el del que entra. Si vuelve a entrar el mismo, no se copia nada.
+ */
 void dispatch(int nuevo_pid)
 {
+    // 0. Mismo proceso: sus registros ya están en la CPU
+    if (nuevo_pid != NULL_PID && nuevo_pid == current_pid)
+    {
+        process_hot[current_pid].state = STATE_RUNNING;
+        context.PSW.Mode = USER_MODE;
+        context.PSW.Interrupts = 1;
+        return;
+    }
+
+    long long start = now_ns();
+
     // 1. Si había un proceso corriendo, lo pasamos a LISTO (a menos que haya terminado o dormido)
-    if (current_pid != NULL_PID && process_table[current_pid].state == STATE_RUNNING)
+    //    y SALVAMOS SU CONTEXTO, tal como lo tenía antes de entrar al kernel
+    if (current_pid != NULL_PID)
     {
-        process_table[current_pid].state = STATE_READY;
+        if (process_hot[current_pid].state == STATE_RUNNING)
+        {
+            process_hot[current_pid].state = STATE_READY;
+        }
+        if (process_hot[current_pid].state != STATE_TERMINATED)
+        {
+            process_table[current_pid].context = context;
+            process_table[current_pid].context.PSW.Mode = irq_saved_mode;
+            process_table[current_pid].context.PSW.Interrupts = irq_saved_interrupts;
+        }
     }
 
     // 2. Actualizamos el PID actual
     current_pid = nuevo_pid;
+    if (current_pid == NULL_PID)
+    {
+        switch_stats.total_ns += now_ns() - start;
+        write_log(0, ">> PLANIFICADOR: No hay procesos listos. CPU libre.\n");
+        return;
+    }
 
     // 3. Pasamos el nuevo proceso a estado RUNNING
-    process_table[current_pid].state = STATE_RUNNING;
+    process_hot[current_pid].state = STATE_RUNNING;
 
     // 4. CARGAR CONTEXTO
     // Copiamos todos los registros del PCB a la CPU global
@@ -173,10 +234,18 @@ void dispatch(int nuevo_pid)
     context.PSW.Mode = USER_MODE;
     context.PSW.Interrupts = 1;
 
+    switch_stats.switches++;
+    switch_stats.total_ns += now_ns() - start;
+
     write_log(0, ">> PLANIFICADOR: Cambio de contexto -> Entra PID %d (%s) a ejecutar.\n",
               current_pid, process_table[current_pid].name);
 }
 
+void cpu_get_switch_stats(CtxSwitchStats *stats)
+{
+    *stats = switch_stats;
+}
+
 void cpu_interrupt(int interrupt_code)
 {
     // Si ya hay una interrupción pendiente y llega el reloj, la ignoramos
@@ -197,13 +266,10 @@ int handle_interrupt()
     write_log(0, "INT: Iniciando secuencia de interrupción %d...\n", interrupt_code_val);
     int pid_antes = current_pid; // Guardamos quién estaba corriendo
 
-    // 1. SALVAR CONTEXTO EN EL PCB (Dispatcher)
-    // Si hay un proceso corriendo actualmente, guardamos su estado exacto.
-    if (current_pid != NULL_PID)
-    {
-        process_table[current_pid].context = context;
-        write_log(0, "DISPATCHER: Contexto salvado para PID=%d (PC=%d)\n", current_pid, context.PSW.PC);
-    }
+    // 1. EL CONTEXTO SE QUEDA EN LA CPU
+    // Sólo se recuerda el modo del proceso; dispatch salva todo si el kernel cambia de proceso
+    irq_saved_mode = context.PSW.Mode;
+    irq_saved_interrupts = context.PSW.Interrupts;
 
     // 2. CAMBIAR A MODO KERNEL
     context.PSW.Mode = KERNEL_MODE; // Ahora somos omnipotentes
@@ -219,12 +285,16 @@ int handle_interrupt()
     // Siempre retornamos 0 para que el ciclo de la CPU en main.c siga vivo
     // ejecutando el siguiente proceso que el planificador haya elegido.
 
-    // Si el Kernel NO hizo un cambio de proceso, debemos devolverle la CPU al
-    // usuario actual restaurando sus registros (incluyendo su USER_MODE).
-    if (current_pid != NULL_PID && current_pid == pid_antes && process_table[current_pid].state == STATE_RUNNING)
+    // Si el Kernel NO hizo un cambio de proceso, sus registros siguen en la CPU
+    // (el kernel los modificó en el lugar): sólo se devuelve su modo.
+    if (current_pid != NULL_PID && current_pid == pid_antes && process_hot[current_pid].state == STATE_RUNNING)
     {
-        context = process_table[current_pid].context;
+        context.PSW.Mode = irq_saved_mode;
+        context.PSW.Interrupts = irq_saved_interrupts;
+        switch_stats.avoided++;
     }
+    irq_saved_mode = USER_MODE;
+    irq_saved_interrupts = 1;
     return 0;
 }
 
@@ -263,12 +333,127 @@ int int_to_sm(int int_val)
     return (signo * 10000000) + int_val;
 }
 
-int cpu()
+// --- Operaciones atómicas: se ejecutan dentro de bus_rmw con el bus retenido ---
+
+static int rmw_fetch_add(Word old_value, Word *new_value, void *arg)
+{
+    long long suma = (long long)sm_to_int(old_value) + sm_to_int(*(Word *)arg);
+    *new_value = int_to_sm((int)suma);
+    return 1;
+}
+
+static int rmw_exchange(Word old_value, Word *new_value, void *arg)
+{
+    (void)old_value;
+    *new_value = *(Word *)arg;
+    return 1;
+}
+
+// arg apunta a {esperado, nuevo}
+static int rmw_compare_swap(Word old_value, Word *new_value, void *arg)
+{
+    Word *par = (Word *)arg;
+    if (sm_to_int(old_value) != sm_to_int(par[0]))
+        return 0;
+    *new_value = par[1];
+    return 1;
+}
+
+// Registro direccionable por las instrucciones registro a registro (0-7 = R0-R7, 8 = AC, 9 = RX)
+static Word *gp_register(int n)
+{
+    if (n >= 0 && n < NUM_GPR)
+        return &context.R[n];
+    if (n == 8)
+        return &context.AC;
+    if (n == 9)
+        return &context.RX;
+    return NULL;
+}
+
+// --- Instrucciones de bloque: cada paso corre dentro de bus_block con el bus retenido ---
+
+// Palabras por tramo: el bus se suelta entre tramos (el DMA puede avanzar) y cada tramo
+// extra cuenta como un ciclo de reloj, así que un bloque largo puede ser interrumpido
+#define BLOCK_CHUNK_WORDS 8
+
+typedef struct
+{
+    int opcode;
+    int src;        // Dirección física del bloque operando
+    int dst;        // Dirección física del segundo bloque (BMOV/BCMP)
+    int len;
+    int backward;   // BMOV con destino solapado por delante: se copia de atrás hacia adelante
+    Word fill;      // Valor de BFILL
+    long long sum;  // Acumulado de BSUM
+    int diff;       // BCMP: 0 iguales hasta ahora, 1 menor, 2 mayor
+} BlockOp;
+
+static int block_step(int k, void *arg)
+{
+    BlockOp *b = (BlockOp *)arg;
+    int i = b->backward ? b->len - 1 - k : k;
+    Word x, y;
+
+    switch (b->opcode)
+    {
+    case OP_BMOV:
+        if (mem_read_physical(b->src + i, &x) != 0 || mem_write_physical(b->dst + i, x) != 0)
+            return -1;
+        break;
+    case OP_BFILL:
+        if (mem_write_physical(b->src + i, b->fill) != 0)
+            return -1;
+        break;
+    case OP_BCMP:
+        if (mem_read_physical(b->src + i, &x) != 0 || mem_read_physical(b->dst + i, &y) != 0)
+            return -1;
+        if (sm_to_int(x) != sm_to_int(y))
+        {
+            b->diff = (sm_to_int(x) < sm_to_int(y)) ? 1 : 2;
+            return 1; // Primera diferencia: no hace falta seguir
+        }
+        break;
+    case OP_BSUM:
+        if (mem_read_physical(b->src + i, &x) != 0)
+            return -1;
+        b->sum += sm_to_int(x);
+        break;
+    }
+    return 0;
+}
+
+// Traduce [logical, logical+len) con una sola verificación de rango:
+// el bloque completo debe caer en la partición o en el segmento compartido
+static int mmu_translate_range(int logical, int len)
+{
+    int phys = mmu_translate(logical);
+    if (phys == -1)
+        return -1;
+
+    int ok;
+    if (context.PSW.Mode == KERNEL_MODE)
+        ok = (phys + len <= MEM_SIZE);
+    else if (context.SL > 0 && logical >= SHM_LOGICAL_BASE && logical < SHM_LOGICAL_BASE + context.SL)
+        ok = (logical + len <= SHM_LOGICAL_BASE + context.SL);
+    else
+        ok = (phys + len - 1 <= context.RL);
+
+    if (!ok)
+    {
+        write_log(1, "ERROR MMU: Bloque fuera de segmento. Logica:%d-%d (Limites RB:%d - RL:%d)\n",
+                  logical, logical + len - 1, context.RB, context.RL);
+        cpu_interrupt(INT_INV_ADDR);
+        return -1;
+    }
+    return phys;
+}
+
+// Avanza un ciclo de CPU. Cada 2 ciclos de CPU simulamos 1 quantum
+static void clock_tick()
 {
     static int cycle_counter = 0;
     cycle_counter++;
-
-    // Cada 2 ciclos de CPU simulamos 1 quantum
     if (cycle_counter >= 2)
     {
         cycle_counter = 0;
@@ -278,6 +463,19 @@ int cpu()
             cpu_interrupt(INT_CLOCK); // Código 3
         }
     }
+}
+
+int cpu()
+{
+    // CPU libre (todos dormidos o esperando entrada): el reloj sigue corriendo
+    // para que el kernel pueda despertarlos, pero no hay instrucción que buscar
+    if (current_pid == NULL_PID)
+    {
+        context.PSW.Mode = KERNEL_MODE;
+        context.PSW.Interrupts = 1;
+    }
+
+    clock_tick();
     // --- SIMULACIÓN DE RELOJ ---
     usleep(2000); // 2ms por ciclo de instrucción
 
@@ -297,6 +495,8 @@ int cpu()
         }
         return 0; // Ciclo consumido por la interrupción (sin fetch)
     }
+    if (current_pid == NULL_PID)
+        return 0; // Ciclo ocioso
     // Etapa Fetch
     context.MAR = context.PSW.PC;               // Cargar PC en MAR
     int phys_addr = mmu_translate(context.MAR); // traducir direccion
@@ -551,6 +751,120 @@ int cpu()
         }
     }
     break;
+    case OP_JZ:   // 43 - Jump if Zero (CC == 0)
+    case OP_JNZ:  // 44 - Jump if Not Zero (CC != 0)
+    case OP_JNEG: // 45 - Jump if Negative (CC == 1)
+    case OP_JPOS: // 46 - Jump if Positive (CC == 2)
+    case OP_JOVF: // 47 - Jump if Overflow (CC == 3)
+    {
+        // Sólo se consulta el CC que dejó la última operación (COMP, SUM, etc.)
+        int cc = context.PSW.CC;
+        int condition = 0;
+        switch (opcode)
+        {
+        case OP_JZ:
+            condition = (cc == 0);
+            break;
+        case OP_JNZ:
+            condition = (cc != 0);
+            break;
+        case OP_JNEG:
+            condition = (cc == 1);
+            break;
+        case OP_JPOS:
+            condition = (cc == 2);
+            break;
+        case OP_JOVF:
+            condition = (cc == 3);
+            break;
+        }
+
+        if (condition)
+        {
+            context.PSW.PC = operand;
+            write_log(0, "JUMP (Op %d): CC=%d cumple. Salto a %d.\n", opcode, cc, operand);
+        }
+        else
+        {
+            write_log(0, "JUMP (Op %d): CC=%d no cumple.\n", opcode, cc);
+        }
+    }
+    break;
+    case OP_MOVR: // 48
+    case OP_ADDR: // 49
+    case OP_SUBR: // 50
+    case OP_MULR: // 51
+    case OP_DIVR: // 52
+    case OP_CMPR: // 53
+    {
+        // La fuente es otro registro (modo 0) o un inmediato de 4 dígitos (modo 1): no se toca el bus
+        Word *rd;
+        int fuente = 0;
+        if (mode == 0)
+        {
+            // Sólo los dos últimos dígitos nombran registros: el resto debe ser cero
+            rd = (operand > 99) ? NULL : gp_register(operand / 10);
+            Word *rs = gp_register(operand % 10);
+            if (rs == NULL)
+                rd = NULL;
+            else
+                fuente = sm_to_int(*rs);
+        }
+        else if (mode == 1)
+        {
+            rd = gp_register(operand / 10000);
+            fuente = operand % 10000;
+        }
+        else
+        {
+            rd = NULL;
+        }
+        if (rd == NULL)
+        {
+            write_log(1, "ERROR: Operando de registro inválido (modo %d, operando %d)\n", mode, operand);
+            cpu_interrupt(INT_INV_INSTR);
+            return 0;
+        }
+
+        if (opcode == OP_MOVR)
+        {
+            *rd = int_to_sm(fuente);
+            write_log(0, "MOVR: Registro <- %d\n", fuente);
+            break;
+        }
+
+        int destino = sm_to_int(*rd);
+        if (opcode == OP_CMPR)
+        {
+            context.PSW.CC = (destino == fuente) ? 0 : (destino < fuente ? 1 : 2);
+            write_log(0, "CMPR: %d vs %d (CC=%d)\n", destino, fuente, context.PSW.CC);
+            break;
+        }
+        if (opcode == OP_DIVR && fuente == 0)
+        {
+            write_log(1, "ERROR ALU: División por CERO detectada.\n");
+            cpu_interrupt(INT_INV_INSTR);
+            return 0;
+        }
+
+        long long resultado_temp;
+        if (opcode == OP_ADDR)
+            resultado_temp = (long long)destino + fuente;
+        else if (opcode == OP_SUBR)
+            resultado_temp = (long long)destino - fuente;
+        else if (opcode == OP_MULR)
+            resultado_temp = (long long)destino * fuente;
+        else
+            resultado_temp = (long long)destino / fuente;
+
+        // Mismo CC que las operaciones de AC; int_to_sm marca overflow (CC=3)
+        context.PSW.CC = (resultado_temp == 0) ? 0 : (resultado_temp < 0 ? 1 : 2);
+        if (resultado_temp > 9999999 || resultado_temp < -9999999)
+            resultado_temp = (resultado_temp > 0) ? 10000000 : -10000000;
+        *rd = int_to_sm((int)resultado_temp);
+        write_log(0, "ALU: Registro (Op %d) %d, %d = %d\n", opcode, destino, fuente, sm_to_int(*rd));
+    }
+    break;
     case OP_J: // 27 (Salto incondicional)
         context.PSW.PC = operand;
         write_log(0, "J: Salto incondicional a %d\n", operand);
@@ -773,6 +1087,41 @@ int cpu()
         }
         break;
 
+    case OP_CALL: // 41
+    {
+        // Destino como en J; en modo indexado RX permite tablas de saltos
+        int destino = (mode == 2) ? operand + context.RX : operand;
+        if (push_stack(context.PSW.PC) == 0)
+        {
+            write_log(0, "CALL: Retorno %d apilado (SP=%d). Salto a %d\n", context.PSW.PC, context.SP, destino);
+            context.PSW.PC = destino;
+        }
+        else
+        {
+            cpu_interrupt(INT_OVERFLOW);
+        }
+    }
+    break;
+    case OP_RET: // 42
+    {
+        int retorno;
+        if (pop_stack(&retorno) != 0)
+        {
+            cpu_interrupt(INT_UNDERFLOW);
+            break;
+        }
+        retorno = sm_to_int(retorno);
+        if (retorno < 0)
+        {
+            write_log(1, "ERROR: RET a dirección inválida (%d)\n", retorno);
+            cpu_interrupt(INT_INV_ADDR);
+            break;
+        }
+        context.PSW.PC = retorno;
+        write_log(0, "RET: Regreso a %d (SP=%d)\n", retorno, context.SP);
+    }
+    break;
+
     // --- E/S DMA ---
     // GRUPO 1: Configuración simple (Track, Cyl, Sec, IO)
     case OP_SDMAP:  // 28
@@ -831,6 +1180,176 @@ int cpu()
         }
         usleep(20000); // Simular retardo de activación
         break;
+    case OP_FADD: // 34
+    case OP_XCHG: // 35
+    case OP_CAS:  // 36
+    {
+        // Necesitan una dirección de memoria: mismo cálculo que get_value, sin modo inmediato
+        if (mode == 1 || mode < 0 || mode > 2)
+        {
+            write_log(1, "ERROR: Modo de direccionamiento inválido (%d) para atómica %d\n", mode, opcode);
+            cpu_interrupt(INT_INV_INSTR);
+            return 0;
+        }
+        int log_addr = (mode == 2) ? operand + context.RX : operand;
+        int phys_addr = mmu_translate(log_addr);
+        if (phys_addr == -1)
+            break;
+
+        Word old_value;
+        int rmw_result;
+        if (opcode == OP_FADD)
+        {
+            rmw_result = bus_rmw(phys_addr, rmw_fetch_add, &context.AC, &old_value, 0);
+        }
+        else if (opcode == OP_XCHG)
+        {
+            rmw_result = bus_rmw(phys_addr, rmw_exchange, &context.AC, &old_value, 0);
+        }
+        else
+        {
+            // El valor esperado se toma del tope de la pila (igual que los saltos condicionales)
+            Word par[2];
+            if (bus_read(context.SP, &par[0], 0) != 0)
+            {
+                write_log(1, "ERROR: Fallo al leer Stack para CAS.\n");
+                break;
+            }
+            par[1] = context.AC;
+            rmw_result = bus_rmw(phys_addr, rmw_compare_swap, par, &old_value, 0);
+        }
+
+        if (rmw_result == -1)
+        {
+            write_log(1, "FATAL: Error de Bus/Memoria en atómica %d (phys=%d)\n", opcode, phys_addr);
+            return 1;
+        }
+
+        if (opcode == OP_FADD)
+        {
+            long long nuevo = (long long)sm_to_int(old_value) + sm_to_int(context.AC);
+            if (nuevo > 9999999 || nuevo < -9999999)
+                context.PSW.CC = 3; // Overflow (int_to_sm ya truncó)
+            else
+                context.PSW.CC = (nuevo == 0) ? 0 : (nuevo < 0 ? 1 : 2);
+            write_log(0, "FADD: Mem[%d] %d + %d (previo devuelto en AC)\n",
+                      phys_addr, sm_to_int(old_value), sm_to_int(context.AC));
+        }
+        else if (opcode == OP_XCHG)
+        {
+            write_log(0, "XCHG: Mem[%d] <- %d, AC <- %d\n", phys_addr, sm_to_int(context.AC), sm_to_int(old_value));
+        }
+        else
+        {
+            context.PSW.CC = (rmw_result == 1) ? 0 : 1; // 0 = intercambio hecho
+            write_log(0, "CAS: Mem[%d] previo %d, %s\n", phys_addr, sm_to_int(old_value),
+                      rmw_result == 1 ? "intercambio realizado" : "sin cambio");
+        }
+        context.AC = old_value;
+    }
+    break;
+    case OP_BMOV:  // 37
+    case OP_BFILL: // 38
+    case OP_BCMP:  // 39
+    case OP_BSUM:  // 40
+    {
+        // RX es la longitud, así que sólo hay modo directo
+        int len = sm_to_int(context.RX);
+        if (mode != 0 || len < 0)
+        {
+            write_log(1, "ERROR: Instrucción de bloque %d inválida (modo %d, longitud %d)\n", opcode, mode, len);
+            cpu_interrupt(INT_INV_INSTR);
+            return 0;
+        }
+
+        BlockOp b = {0};
+        b.opcode = opcode;
+        b.len = len;
+        b.fill = context.AC;
+        if (len > 0)
+        {
+            b.src = mmu_translate_range(operand, len);
+            if (b.src == -1)
+                break;
+            if (opcode == OP_BMOV || opcode == OP_BCMP)
+            {
+                b.dst = mmu_translate_range(sm_to_int(context.AC), len);
+                if (b.dst == -1)
+                    break;
+            }
+        }
+        b.backward = (opcode == OP_BMOV && b.dst > b.src && b.dst < b.src + len);
+
+        // Reanudación: BLK dice cuántas palabras se hicieron antes de la interrupción
+        int total = context.BLK;
+        if (total > len)
+            total = 0; // RX cambió: el progreso guardado ya no aplica
+        if (opcode == OP_BSUM && total > 0)
+            b.sum = context.BLKSUM;
+
+        // Un tramo por llamada a bus_block; entre tramos se atienden interrupciones
+        while (total < len)
+        {
+            int count = len - total;
+            if (count > BLOCK_CHUNK_WORDS)
+                count = BLOCK_CHUNK_WORDS;
+            int done = bus_block(block_step, &b, total, count, 0);
+            if (done == -1)
+            {
+                write_log(1, "FATAL: Error de Bus/Memoria en instrucción de bloque %d\n", opcode);
+                context.BLK = 0;
+                return 1;
+            }
+            total += done;
+            if (b.diff != 0 || total >= len)
+                break;
+
+            clock_tick();
+            if (interrupt_pending && context.PSW.Interrupts)
+                break;
+        }
+
+        if (opcode == OP_BCMP && b.diff != 0)
+        {
+            context.PSW.CC = b.diff;
+            context.AC = total - 1; // Palabras iguales antes de la diferencia
+            context.BLK = 0;
+            write_log(0, "BCMP: Diferencia en la palabra %d (CC=%d)\n", total - 1, b.diff);
+            break;
+        }
+
+        if (total < len)
+        {
+            // Interrumpida: se guarda el progreso y se repite la instrucción al volver
+            context.BLK = total;
+            context.BLKSUM = b.sum;
+            context.PSW.PC--;
+            write_log(0, "BLOQUE (Op %d): Interrumpida tras %d/%d palabras\n", opcode, total, len);
+            break;
+        }
+
+        context.BLK = 0;
+        if (opcode == OP_BCMP)
+        {
+            context.PSW.CC = 0;
+            context.AC = len;
+        }
+        else if (opcode == OP_BSUM)
+        {
+            // La suma se satura a la magnitud máxima de una palabra sólo al final
+            int saturada = (b.sum > 9999999 || b.sum < -9999999);
+            if (saturada)
+                b.sum = (b.sum > 0) ? 9999999 : -9999999;
+            context.AC = int_to_sm((int)b.sum);
+            context.BLKSUM = 0;
+            if (saturada)
+                context.PSW.CC = 3; // Overflow
+            else
+                context.PSW.CC = (b.sum == 0) ? 0 : (b.sum < 0 ? 1 : 2);
+        }
+        write_log(0, "BLOQUE (Op %d): %d palabras desde %d\n", opcode, len, b.src);
+    }
+    break;
     default:
         write_log(1, "ERROR: Instruccion Ilegal (Opcode %d) en PC=%d\n", opcode, context.PSW.PC - 1);
         cpu_interrupt(INT_INV_INSTR); // Interrupción 5
@@ -32,6 +32,19 @@ void cpu_interrupt(int interrupt_code);
 // manejar interrupciones del cpu
 int handle_interrupt();
 
+// Cambia el proceso en la CPU (salva el contexto del que sale y carga el del que entra)
+void dispatch(int nuevo_pid);
+
+// Estadísticas de cambios de contexto
+typedef struct
+{
+    long switches;      // Cambios reales (se copió el contexto de entrada)
+    long avoided;       // Interrupciones que volvieron al mismo proceso sin copiar nada
+    long long total_ns; // Tiempo total gastado salvando/cargando contextos
+} CtxSwitchStats;
+
+void cpu_get_switch_stats(CtxSwitchStats *stats);
+
 // acciones normales del cpu, las 34 instruc
 int cpu();
 
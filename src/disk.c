@@ -2,77 +2,546 @@
 #include "log.h"
 #include <pthread.h>
 #include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-// Inicializar un disco como un arreglo global estático tridimensional (es de 4D para simplificar las cosas)
-// Cada sector almacena exactamente 9 caracteres
-static char DISK[DISK_TRACKS][DISK_CYLINDERS][DISK_SECTORS][SECTOR_BYTES];
+// Cabecera de la imagen: permite reconocer una imagen válida y con la misma geometría
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tracks;
+    uint32_t cylinders;
+    uint32_t sectors;
+    uint32_t sector_bytes;
+} DiskHeader;
+
+// Distribución del archivo imagen: cabecera + metadatos del SO + sectores
+// Los sectores siguen siendo un arreglo de 4D (pista, cilindro, sector, bytes)
+typedef struct
+{
+    DiskHeader header;
+    unsigned char meta[DISK_META_BYTES];
+    char data[DISK_TRACKS][DISK_CYLINDERS][DISK_SECTORS][SECTOR_BYTES];
+} DiskImage;
+
+// El disco vive en el archivo imagen, mapeado en memoria con mmap
+static DiskImage *disk_img = NULL;
+static int disk_fd = -1;
+static char disk_path[256] = DISK_IMAGE_DEFAULT;
+static int disk_restored = 0;
 
 // Se garantiza que solo un hilo accederá al disco a la vez mediante el bus
 static pthread_mutex_t disk_lock;
 
-int disk_init(void)
+// Cola de peticiones atendida por el hilo del disco (protegida por disk_lock)
+static DiskRequest *queue_head = NULL;
+static int queue_len = 0;
+static pthread_cond_t queue_cv;   // Hay peticiones nuevas
+static pthread_cond_t done_cv;    // Alguna petición se completó
+static pthread_t disk_thread;
+static int disk_thread_running = 0;
+
+// Estado del brazo y planificación
+static DiskSchedPolicy policy = DISK_SCHED_CLOOK;
+static int head_pos = 0;      // Cilindro lógico bajo el brazo
+static int head_angle = 0;    // Sector que está pasando bajo el cabezal
+static int head_dir = 1;      // Sentido del barrido (SCAN): 1 sube, -1 baja
+static DiskStats stats;
+
+#define DISK_POSITIONS (DISK_TRACKS * DISK_CYLINDERS)
+
+void disk_set_image_path(const char *path)
+{
+    if (path == NULL || path[0] == '\0')
+        return;
+    strncpy(disk_path, path, sizeof(disk_path) - 1);
+    disk_path[sizeof(disk_path) - 1] = '\0';
+}
+
+const char *disk_get_image_path(void)
+{
+    return disk_path;
+}
+
+// Escribe una cabecera nueva y deja todos los sectores vacíos
+static void disk_write_fresh_image(void)
 {
     // Inicializar todas las posiciones con una cadena vacía con memset
-    memset(DISK, '\0', sizeof(DISK));
+    memset(disk_img, '\0', sizeof(DiskImage));
+    disk_img->header.magic = DISK_MAGIC;
+    disk_img->header.version = DISK_VERSION;
+    disk_img->header.tracks = DISK_TRACKS;
+    disk_img->header.cylinders = DISK_CYLINDERS;
+    disk_img->header.sectors = DISK_SECTORS;
+    disk_img->header.sector_bytes = SECTOR_BYTES;
+}
+
+static int disk_header_is_valid(const DiskHeader *h)
+{
+    return h->magic == DISK_MAGIC && h->version == DISK_VERSION &&
+           h->tracks == DISK_TRACKS && h->cylinders == DISK_CYLINDERS &&
+           h->sectors == DISK_SECTORS && h->sector_bytes == SECTOR_BYTES;
+}
+
+static long long now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static int request_position(const DiskRequest *req)
+{
+    return req->track * DISK_CYLINDERS + req->cylinder;
+}
+
+// Sectores que deben pasar bajo el cabezal antes de llegar al sector pedido
+static int rotational_distance(int sector)
+{
+    return (sector - head_angle + DISK_SECTORS) % DISK_SECTORS;
+}
+
+// Costo de elegir la petición: desplazamiento del brazo y, a igual cilindro, la rotación
+static long request_cost(const DiskRequest *req, int seek)
+{
+    return (long)seek * DISK_SECTORS + rotational_distance(req->sector);
+}
+
+/**
+ * Elige (y saca de la cola) la siguiente petición según la política activa.
+ * En *seek_out devuelve los cilindros lógicos que recorre el brazo para atenderla.
+ * Debe llamarse con disk_lock tomado y la cola no vacía.
+ */
+static DiskRequest *pick_next_request(int *seek_out)
+{
+    DiskRequest **best = NULL;
+    long best_cost = 0;
+    int best_seek = 0;
+
+    if (policy == DISK_SCHED_FCFS)
+    {
+        best = &queue_head;
+        best_seek = abs(request_position(queue_head) - head_pos);
+    }
+    else if (policy == DISK_SCHED_SSTF)
+    {
+        for (DiskRequest **it = &queue_head; *it != NULL; it = &(*it)->next)
+        {
+            int seek = abs(request_position(*it) - head_pos);
+            long cost = request_cost(*it, seek);
+            if (best == NULL || cost < best_cost)
+            {
+                best = it;
+                best_cost = cost;
+                best_seek = seek;
+            }
+        }
+    }
+    else
+    {
+        // SCAN y C-LOOK: primero las peticiones en el sentido del barrido
+        int dir = (policy == DISK_SCHED_CLOOK) ? 1 : head_dir;
+        for (DiskRequest **it = &queue_head; *it != NULL; it = &(*it)->next)
+        {
+            int delta = (request_position(*it) - head_pos) * dir;
+            if (delta < 0)
+                continue;
+            long cost = request_cost(*it, delta);
+            if (best == NULL || cost < best_cost)
+            {
+                best = it;
+                best_cost = cost;
+                best_seek = delta;
+            }
+        }
+
+        if (best == NULL && policy == DISK_SCHED_SCAN)
+        {
+            // Llegar al extremo y devolverse: atender la más cercana en el nuevo sentido
+            int edge = (head_dir > 0) ? DISK_POSITIONS - 1 : 0;
+            for (DiskRequest **it = &queue_head; *it != NULL; it = &(*it)->next)
+            {
+                int seek = abs(edge - head_pos) + abs(edge - request_position(*it));
+                long cost = request_cost(*it, seek);
+                if (best == NULL || cost < best_cost)
+                {
+                    best = it;
+                    best_cost = cost;
+                    best_seek = seek;
+                }
+            }
+            head_dir = -head_dir;
+        }
+        else if (best == NULL)
+        {
+            // C-LOOK: salto de regreso a la petición más baja
+            for (DiskRequest **it = &queue_head; *it != NULL; it = &(*it)->next)
+            {
+                if (best == NULL || request_position(*it) < request_position(*best) ||
+                    (request_position(*it) == request_position(*best) && (*it)->sector < (*best)->sector))
+                {
+                    best = it;
+                }
+            }
+            best_seek = abs(head_pos - request_position(*best));
+        }
+    }
+
+    DiskRequest *req = *best;
+    *best = req->next;
+    req->next = NULL;
+    queue_len--;
+    *seek_out = best_seek;
+    return req;
+}
+
+// Hilo del disco: atiende la cola según la política y simula la latencia mecánica
+static void *disk_service(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&disk_lock);
+    while (1)
+    {
+        while (queue_head == NULL && disk_thread_running)
+            pthread_cond_wait(&queue_cv, &disk_lock);
+
+        if (queue_head == NULL && !disk_thread_running)
+            break;
+
+        int seek;
+        DiskRequest *req = pick_next_request(&seek);
+        long long start = now_us();
+
+        int rot = rotational_distance(req->sector);
+        long latency = DISK_TRANSFER_US + (long)rot * DISK_ROT_US_PER_SECTOR;
+        if (seek > 0)
+            latency += DISK_SEEK_SETTLE_US + (long)seek * DISK_SEEK_US_PER_CYL;
+
+        head_pos = request_position(req);
+        head_angle = (req->sector + 1) % DISK_SECTORS;
+
+        // Simular Latencia de Disco sin bloquear a quienes encolan peticiones
+        pthread_mutex_unlock(&disk_lock);
+        usleep(latency);
+        pthread_mutex_lock(&disk_lock);
+
+        if (req->write)
+        {
+            // Copiar el contenido del buffer de entrada al sector
+            memcpy(disk_img->data[req->track][req->cylinder][req->sector], req->buf, SECTOR_BYTES);
+            write_log(0, "Escribiendo en disco: pista %d, cilindro %d, sector %d, data: %.9s\n",
+                      req->track, req->cylinder, req->sector, req->buf);
+        }
+        else
+        {
+            // Copiar el contenido del sector al buffer de salida
+            memcpy(req->buf, disk_img->data[req->track][req->cylinder][req->sector], SECTOR_BYTES);
+            write_log(0, "Leyendo en disco: pista %d, cilindro %d, sector %d, data: %.9s\n",
+                      req->track, req->cylinder, req->sector, req->buf);
+        }
+
+        stats.requests++;
+        stats.seek_distance += seek;
+        stats.wait_us += start - req->enqueue_us;
+        stats.service_us += latency;
+        stats.head = head_pos;
+
+        req->result = 0;
+        req->done = 1;
+        pthread_cond_broadcast(&done_cv);
+    }
+    pthread_mutex_unlock(&disk_lock);
+    return NULL;
+}
+
+int disk_init(void)
+{
+    disk_fd = open(disk_path, O_RDWR | O_CREAT, 0644);
+    if (disk_fd < 0)
+    {
+        write_log(1, "DISK: No se pudo abrir la imagen '%s'\n", disk_path);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(disk_fd, &st) != 0)
+    {
+        write_log(1, "DISK: No se pudo consultar la imagen '%s'\n", disk_path);
+        close(disk_fd);
+        disk_fd = -1;
+        return -1;
+    }
+
+    // Si el archivo es nuevo o de otro tamaño se ajusta (el contenido se valida abajo)
+    int size_ok = (st.st_size == (off_t)sizeof(DiskImage));
+    if (!size_ok && ftruncate(disk_fd, sizeof(DiskImage)) != 0)
+    {
+        write_log(1, "DISK: No se pudo dimensionar la imagen '%s'\n", disk_path);
+        close(disk_fd);
+        disk_fd = -1;
+        return -1;
+    }
+
+    disk_img = mmap(NULL, sizeof(DiskImage), PROT_READ | PROT_WRITE, MAP_SHARED, disk_fd, 0);
+    if (disk_img == MAP_FAILED)
+    {
+        write_log(1, "DISK: Fallo al mapear la imagen '%s'\n", disk_path);
+        disk_img = NULL;
+        close(disk_fd);
+        disk_fd = -1;
+        return -1;
+    }
+
+    if (size_ok && disk_header_is_valid(&disk_img->header))
+    {
+        disk_restored = 1;
+        write_log(0, "DISK: Imagen '%s' recuperada (sin reformatear)\n", disk_path);
+    }
+    else
+    {
+        disk_restored = 0;
+        disk_write_fresh_image();
+        write_log(0, "DISK: Imagen '%s' formateada\n", disk_path);
+    }
+
     //Verificar errores que pueda arrojar esta funcion de abajo
     if(pthread_mutex_init(&disk_lock, NULL))
     {
         write_log(1, "DISK: Error al inicializar el mutex del disco\n");
+        munmap(disk_img, sizeof(DiskImage));
+        disk_img = NULL;
+        close(disk_fd);
+        disk_fd = -1;
+        return -1;
+    }
+
+    // Cola de peticiones y el hilo que la atiende
+    pthread_cond_init(&queue_cv, NULL);
+    pthread_cond_init(&done_cv, NULL);
+    queue_head = NULL;
+    queue_len = 0;
+    head_pos = 0;
+    head_angle = 0;
+    head_dir = 1;
+    memset(&stats, 0, sizeof(stats));
+    disk_thread_running = 1;
+    if (pthread_create(&disk_thread, NULL, disk_service, NULL) != 0)
+    {
+        write_log(1, "DISK: No se pudo crear el hilo del disco\n");
+        disk_thread_running = 0;
+        pthread_cond_destroy(&queue_cv);
+        pthread_cond_destroy(&done_cv);
+        pthread_mutex_destroy(&disk_lock);
+        munmap(disk_img, sizeof(DiskImage));
+        disk_img = NULL;
+        close(disk_fd);
+        disk_fd = -1;
         return -1;
     }
-    write_log(0, "DISK: Disco inicializado correctamente\n");
+    write_log(0, "DISK: Disco inicializado correctamente (planificación %s)\n", disk_policy_name(policy));
     return 0;
 }
 
-int disk_read_sector(int track, int cylinder, int sector, char *out_buf)
+int disk_submit(DiskRequest *req)
 {
     // Validar parámetros
-    if (track < 0 || track >= DISK_TRACKS ||
-        cylinder < 0 || cylinder >= DISK_CYLINDERS ||
-        sector < 0 || sector >= DISK_SECTORS ||
-        out_buf == NULL)
+    if (req == NULL ||
+        req->track < 0 || req->track >= DISK_TRACKS ||
+        req->cylinder < 0 || req->cylinder >= DISK_CYLINDERS ||
+        req->sector < 0 || req->sector >= DISK_SECTORS ||
+        req->buf == NULL || disk_img == NULL)
     {
         return -1;
     }
 
-    // Bloquear el acceso al disco
-    pthread_mutex_lock(&disk_lock);
+    req->done = 0;
+    req->result = -1;
+    req->next = NULL;
+    req->enqueue_us = now_us();
 
-    // Copiar el contenido del sector al buffer de salida
-    memcpy(out_buf, DISK[track][cylinder][sector], SECTOR_BYTES);
-    write_log(0, "Leyendo en disco: pista %d, cilindro %d, sector %d, data: %.9s\n",
-              track, cylinder, sector, out_buf);
-
-    // Desbloquear el acceso al disco
+    // Encolar al final (el orden de llegada sólo lo respeta FCFS)
+    pthread_mutex_lock(&disk_lock);
+    DiskRequest **tail = &queue_head;
+    while (*tail != NULL)
+        tail = &(*tail)->next;
+    *tail = req;
+    queue_len++;
+    if (queue_len > stats.max_queue)
+        stats.max_queue = queue_len;
+    pthread_cond_signal(&queue_cv);
     pthread_mutex_unlock(&disk_lock);
     return 0;
 }
 
+int disk_wait(DiskRequest *req)
+{
+    pthread_mutex_lock(&disk_lock);
+    while (!req->done)
+        pthread_cond_wait(&done_cv, &disk_lock);
+    int result = req->result;
+    pthread_mutex_unlock(&disk_lock);
+    return result;
+}
+
+int disk_read_sector(int track, int cylinder, int sector, char *out_buf)
+{
+    DiskRequest req = {.track = track, .cylinder = cylinder, .sector = sector, .write = 0, .buf = out_buf};
+    if (disk_submit(&req) != 0)
+        return -1;
+    return disk_wait(&req);
+}
+
 int disk_write_sector(int track, int cylinder, int sector, const char *in_buf)
 {
-    // Validar parámetros
-    if (track < 0 || track >= DISK_TRACKS ||
-        cylinder < 0 || cylinder >= DISK_CYLINDERS ||
-        sector < 0 || sector >= DISK_SECTORS ||
-        in_buf == NULL)
-    {
+    // La petición sólo lee de buf al escribir, por eso el cast es seguro
+    DiskRequest req = {.track = track, .cylinder = cylinder, .sector = sector, .write = 1, .buf = (char *)in_buf};
+    if (disk_submit(&req) != 0)
         return -1;
+    return disk_wait(&req);
+}
+
+void disk_set_policy(DiskSchedPolicy new_policy)
+{
+    pthread_mutex_lock(&disk_lock);
+    policy = new_policy;
+    pthread_mutex_unlock(&disk_lock);
+    write_log(0, "DISK: Planificación de la cola cambiada a %s\n", disk_policy_name(new_policy));
+}
+
+DiskSchedPolicy disk_get_policy(void)
+{
+    return policy;
+}
+
+const char *disk_policy_name(DiskSchedPolicy p)
+{
+    switch (p)
+    {
+    case DISK_SCHED_FCFS:
+        return "FCFS";
+    case DISK_SCHED_SSTF:
+        return "SSTF";
+    case DISK_SCHED_SCAN:
+        return "SCAN";
+    case DISK_SCHED_CLOOK:
+        return "C-LOOK";
+    default:
+        return "DESCONOCIDA";
     }
-    // Bloquear el acceso al disco
+}
+
+int disk_policy_from_name(const char *name)
+{
+    if (strcasecmp(name, "fcfs") == 0)
+        return DISK_SCHED_FCFS;
+    if (strcasecmp(name, "sstf") == 0)
+        return DISK_SCHED_SSTF;
+    if (strcasecmp(name, "scan") == 0)
+        return DISK_SCHED_SCAN;
+    if (strcasecmp(name, "clook") == 0 || strcasecmp(name, "c-look") == 0)
+        return DISK_SCHED_CLOOK;
+    return -1;
+}
+
+void disk_get_stats(DiskStats *out)
+{
     pthread_mutex_lock(&disk_lock);
+    *out = stats;
+    pthread_mutex_unlock(&disk_lock);
+}
+
+void disk_reset_stats(void)
+{
+    pthread_mutex_lock(&disk_lock);
+    memset(&stats, 0, sizeof(stats));
+    stats.head = head_pos;
+    pthread_mutex_unlock(&disk_lock);
+}
+
+int disk_to_lba(int track, int cylinder, int sector)
+{
+    return (track * DISK_CYLINDERS + cylinder) * DISK_SECTORS + sector;
+}
 
-    // Copiar el contenido del buffer de entrada al sector
-    memcpy(DISK[track][cylinder][sector], in_buf, SECTOR_BYTES);
-    write_log(0, "Escribiendo en disco: pista %d, cilindro %d, sector %d, data: %.9s\n",
-              track, cylinder, sector, in_buf);
+void disk_from_lba(int lba, int *track, int *cylinder, int *sector)
+{
+    *sector = lba % DISK_SECTORS;
+    *cylinder = (lba / DISK_SECTORS) % DISK_CYLINDERS;
+    *track = lba / (DISK_SECTORS * DISK_CYLINDERS);
+}
+
+void *disk_get_metadata(size_t *size)
+{
+    if (size != NULL)
+        *size = DISK_META_BYTES;
+    if (disk_img == NULL)
+        return NULL;
+    return disk_img->meta;
+}
 
-    // Desbloquear el acceso al disco
+int disk_was_restored(void)
+{
+    return disk_restored;
+}
+
+int disk_sync(void)
+{
+    if (disk_img == NULL)
+        return -1;
+    pthread_mutex_lock(&disk_lock);
+    int result = msync(disk_img, sizeof(DiskImage), MS_SYNC);
     pthread_mutex_unlock(&disk_lock);
+    if (result != 0)
+    {
+        write_log(1, "DISK: Fallo al sincronizar la imagen '%s'\n", disk_path);
+        return -1;
+    }
+    return 0;
+}
+
+int disk_format(void)
+{
+    if (disk_img == NULL)
+        return -1;
+    pthread_mutex_lock(&disk_lock);
+    disk_write_fresh_image();
+    disk_restored = 0;
+    pthread_mutex_unlock(&disk_lock);
+    write_log(0, "DISK: Imagen '%s' formateada por solicitud\n", disk_path);
     return 0;
 }
 
 void disk_destroy(void)
 {
+    // Detener el hilo del disco después de atender lo que quede en cola
+    if (disk_thread_running)
+    {
+        pthread_mutex_lock(&disk_lock);
+        disk_thread_running = 0;
+        pthread_cond_broadcast(&queue_cv);
+        pthread_mutex_unlock(&disk_lock);
+        pthread_join(disk_thread, NULL);
+        pthread_cond_destroy(&queue_cv);
+        pthread_cond_destroy(&done_cv);
+    }
+
+    if (disk_img != NULL)
+    {
+        disk_sync();
+        munmap(disk_img, sizeof(DiskImage));
+        disk_img = NULL;
+    }
+    if (disk_fd >= 0)
+    {
+        close(disk_fd);
+        disk_fd = -1;
+    }
     //Verificar errores que pueda arrojar esta funcion de abajo
     pthread_mutex_destroy(&disk_lock);
-}
\ No newline at end of file
+}
@@ -2,6 +2,7 @@
 #define DISK_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "brain.h"
 
 #define DISK_TRACKS 10
@@ -9,10 +10,65 @@
 #define DISK_SECTORS 100
 #define SECTOR_BYTES 9 // Cada sector almacena exactamente 9 caracteres
 
-// Inicializa el disco. Devuelve 0 ok, -1 error
+// Imagen persistente del disco (archivo en la PC real mapeado con mmap)
+#define DISK_IMAGE_DEFAULT "disco.img"
+#define DISK_MAGIC 0x4D4B4449   // "MKDI"
+#define DISK_VERSION 1
+#define DISK_META_BYTES 16384   // Región de metadatos del SO (tabla de archivos)
+
+// Modelo de latencia (microsegundos)
+// La posición del brazo es el cilindro lógico: pista * DISK_CYLINDERS + cilindro
+#define DISK_SEEK_SETTLE_US 500    // Arranque/asentamiento del brazo cuando hay desplazamiento
+#define DISK_SEEK_US_PER_CYL 100   // Costo por cada cilindro lógico recorrido
+#define DISK_ROT_US_PER_SECTOR 10  // Rotación: una vuelta completa = DISK_SECTORS * 10us
+#define DISK_TRANSFER_US 20        // Transferencia de un sector
+
+#define DISK_TOTAL_SECTORS (DISK_TRACKS * DISK_CYLINDERS * DISK_SECTORS)
+
+// Políticas de planificación de la cola de peticiones
+typedef enum
+{
+    DISK_SCHED_FCFS,  // Orden de llegada
+    DISK_SCHED_SSTF,  // Menor desplazamiento primero
+    DISK_SCHED_SCAN,  // Ascensor: recorre hasta el extremo y se devuelve
+    DISK_SCHED_CLOOK  // Ascensor circular: sólo sube, luego salta a la menor petición
+} DiskSchedPolicy;
+
+// Petición de E/S al disco. La reserva quien la envía (pila o arreglo)
+typedef struct DiskRequest
+{
+    int track;
+    int cylinder;
+    int sector;
+    int write;          // 0 = leer sector, 1 = escribir sector
+    char *buf;          // SECTOR_BYTES bytes de origen/destino
+    int done;           // 1 cuando el hilo del disco la completó
+    int result;         // 0 éxito, -1 error
+    long long enqueue_us;
+    struct DiskRequest *next;
+} DiskRequest;
+
+// Estadísticas de la cola del disco
+typedef struct
+{
+    long requests;           // Peticiones atendidas
+    long long seek_distance; // Cilindros lógicos recorridos en total
+    long long wait_us;       // Tiempo total en cola (llegada -> inicio de servicio)
+    long long service_us;    // Latencia simulada total (búsqueda + rotación + transferencia)
+    int max_queue;           // Mayor profundidad de cola observada
+    int head;                // Posición actual del brazo (cilindro lógico)
+} DiskStats;
+
+// Cambia la ruta del archivo imagen. Debe llamarse antes de disk_init
+void disk_set_image_path(const char *path);
+
+// Ruta del archivo imagen en uso
+const char *disk_get_image_path(void);
+
+// Inicializa el disco: abre (o crea) la imagen y la mapea en memoria. Devuelve 0 ok, -1 error
 int disk_init(void);
 
-// Elimina el semáforo/mutex del disco (eliminar el disco pues)
+// Sincroniza la imagen, la desmapea y elimina el semáforo/mutex del disco
 void disk_destroy(void);
 
 // Leer un sector
@@ -21,4 +77,36 @@ int disk_read_sector(int track, int cylinder, int sector, char *out_buf);
 // Escribir un sector
 int disk_write_sector(int track, int cylinder, int sector, const char *in_buf);
 
-#endif // DISK_H
\ No newline at end of file
+// Encola una petición sin esperar a que se complete. Devuelve 0 ok, -1 parámetros inválidos
+int disk_submit(DiskRequest *req);
+
+// Espera a que una petición enviada se complete. Devuelve su resultado
+int disk_wait(DiskRequest *req);
+
+// Política de planificación de la cola
+void disk_set_policy(DiskSchedPolicy policy);
+DiskSchedPolicy disk_get_policy(void);
+const char *disk_policy_name(DiskSchedPolicy policy);
+int disk_policy_from_name(const char *name); // -1 si no existe
+
+// Estadísticas de la cola
+void disk_get_stats(DiskStats *out);
+void disk_reset_stats(void);
+
+// Conversión entre (pista, cilindro, sector) y número lineal de sector
+int disk_to_lba(int track, int cylinder, int sector);
+void disk_from_lba(int lba, int *track, int *cylinder, int *sector);
+
+// Región de metadatos persistentes (la usa el kernel para guardar la tabla de archivos)
+void *disk_get_metadata(size_t *size);
+
+// Indica si el contenido se recuperó de una imagen existente (1) o se formateó (0)
+int disk_was_restored(void);
+
+// Fuerza la escritura de la imagen al archivo. Devuelve 0 ok, -1 error
+int disk_sync(void);
+
+// Borra todo el contenido del disco (sectores y metadatos)
+int disk_format(void);
+
+#endif // DISK_H
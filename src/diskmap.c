@@ -0,0 +1,113 @@
+#include "diskmap.h"
+#include "log.h"
+#include <string.h>
+
+// Un bit por sector: 1 = ocupado
+static unsigned char bitmap[(DISK_TOTAL_SECTORS + 7) / 8];
+
+static int sector_used(int lba)
+{
+    return (bitmap[lba / 8] >> (lba % 8)) & 1;
+}
+
+static void set_range(int lba, int count, int used)
+{
+    for (int i = lba; i < lba + count && i < DISK_TOTAL_SECTORS; i++)
+    {
+        if (used)
+            bitmap[i / 8] |= (unsigned char)(1 << (i % 8));
+        else
+            bitmap[i / 8] &= (unsigned char)~(1 << (i % 8));
+    }
+}
+
+void diskmap_reset(void)
+{
+    memset(bitmap, 0, sizeof(bitmap));
+}
+
+void diskmap_mark_used(int lba, int count)
+{
+    if (lba < 0 || count <= 0)
+        return;
+    set_range(lba, count, 1);
+}
+
+int diskmap_alloc(int count)
+{
+    if (count <= 0)
+        return 0; // Un programa vacío no ocupa sectores
+
+    int best_start = -1;
+    int best_len = 0;
+    int run_start = -1;
+
+    // Recorrer los huecos libres buscando el más pequeño donde quepa
+    for (int lba = 0; lba <= DISK_TOTAL_SECTORS; lba++)
+    {
+        int is_free = (lba < DISK_TOTAL_SECTORS) && !sector_used(lba);
+        if (is_free && run_start == -1)
+        {
+            run_start = lba;
+        }
+        else if (!is_free && run_start != -1)
+        {
+            int run_len = lba - run_start;
+            if (run_len >= count && (best_start == -1 || run_len < best_len))
+            {
+                best_start = run_start;
+                best_len = run_len;
+                if (run_len == count)
+                    break; // Ajuste exacto, no hay uno mejor
+            }
+            run_start = -1;
+        }
+    }
+
+    if (best_start == -1)
+    {
+        write_log(1, "DISKMAP: No hay %d sectores contiguos libres.\n", count);
+        return -1;
+    }
+
+    set_range(best_start, count, 1);
+    write_log(0, "DISKMAP: Reservados %d sectores desde el sector lineal %d (hueco de %d).\n",
+              count, best_start, best_len);
+    return best_start;
+}
+
+void diskmap_free(int lba, int count)
+{
+    if (lba < 0 || count <= 0)
+        return;
+    set_range(lba, count, 0);
+    write_log(0, "DISKMAP: Liberados %d sectores desde el sector lineal %d.\n", count, lba);
+}
+
+void diskmap_get_stats(DiskMapStats *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->total_sectors = DISK_TOTAL_SECTORS;
+
+    int run_len = 0;
+    for (int lba = 0; lba <= DISK_TOTAL_SECTORS; lba++)
+    {
+        if (lba < DISK_TOTAL_SECTORS && !sector_used(lba))
+        {
+            out->free_sectors++;
+            run_len++;
+        }
+        else if (run_len > 0)
+        {
+            out->free_extents++;
+            if (run_len > out->largest_extent)
+                out->largest_extent = run_len;
+            run_len = 0;
+        }
+    }
+
+    if (out->free_sectors > 0)
+    {
+        out->fragmentation = 100.0 * (1.0 - (double)out->largest_extent / out->free_sectors);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef DISKMAP_H
+#define DISKMAP_H
+
+#include "disk.h"
+
+// Mapa de bits de sectores libres/ocupados del disco virtual.
+// Los programas se ubican en extensiones contiguas de sectores (número lineal, ver disk_to_lba)
+
+typedef struct
+{
+    int total_sectors;   // Capacidad del disco
+    int free_sectors;    // Sectores libres
+    int free_extents;    // Huecos libres contiguos
+    int largest_extent;  // Mayor hueco libre (en sectores)
+    double fragmentation; // 0 = todo el espacio libre es contiguo, 100 = totalmente disperso
+} DiskMapStats;
+
+// Marca todo el disco como libre
+void diskmap_reset(void);
+
+// Marca como ocupada una extensión ya existente (p.ej. al recuperar la tabla de archivos)
+void diskmap_mark_used(int lba, int count);
+
+// Reserva count sectores contiguos en el hueco más pequeño donde quepan (best fit).
+// Retorna el primer sector lineal, o -1 si no hay un hueco suficiente
+int diskmap_alloc(int count);
+
+// Libera una extensión reservada
+void diskmap_free(int lba, int count);
+
+// Estadísticas de ocupación y fragmentación
+void diskmap_get_stats(DiskMapStats *out);
+
+#endif // DISKMAP_H
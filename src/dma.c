@@ -3,6 +3,7 @@
 #include "bus.h"
 #include "cpu.h"
 #include "disk.h"
+#include "cache.h"
 #include "log.h"
 #include <pthread.h>
 #include <stdio.h>
@@ -14,6 +15,11 @@ static DMA_t dma;
 static int dma_initialized = 0;    // Singleton (lo logico es que se trabaje con una sola instancia)
 static pthread_t dma_thread;       // Hilo
 static int dma_thread_running = 0; // Controla si el hilo está activo
+// Cola de direcciones de transferencias terminadas (protegida por dma.lock)
+static int done_addresses[DMA_DONE_QUEUE];
+static int done_head = 0;
+static int done_count = 0;
+static int done_overflow = 0;
 /*
  * 1. DMA debe recibir la operacion dma con su valor
  * 2. el dma_handler debe implementar la logica de la operacion
@@ -29,6 +35,18 @@ static int dma_thread_running = 0; // Controla si el hilo está activo
  * 3. dma_perform_io realiza la operacion de E/S
  */
 
+// Anota la transferencia actual como terminada. Llamar con dma.lock tomado
+static void dma_record_completion()
+{
+    if (done_count == DMA_DONE_QUEUE)
+    {
+        done_overflow = 1;
+        return;
+    }
+    done_addresses[(done_head + done_count) % DMA_DONE_QUEUE] = dma.ADDRESS;
+    done_count++;
+}
+
 int dma_init()
 {
     if (dma_initialized)
@@ -49,6 +67,9 @@ int dma_init()
     dma.IO = 0;
     dma.ADDRESS = 0;
     dma.BUSY = 0;
+    done_head = 0;
+    done_count = 0;
+    done_overflow = 0;
     dma_thread_running = 0;
     dma_initialized = 1;
     write_log(0, "DMA: inicializado exitosamente\n");
@@ -159,8 +180,7 @@ void *dma_perform_io(void *arg)
     int result;                // Variable para resultados de operaciones de disco
     write_log(0, "DMA: Hilo de transferencia iniciado\n");
 
-    // Simular Latencia de Disco
-    usleep(20000);
+    // La latencia de disco ya no es fija: la simula la cola del disco (búsqueda + rotación)
 
     // 1. Adquirir exclusión mutua
     pthread_mutex_lock(&dma.lock);
@@ -174,6 +194,7 @@ void *dma_perform_io(void *arg)
 
         dma.STATE = 1; // 1 = error
         dma.BUSY = 0;  // Liberar el DMA para nuevas operaciones
+        dma_record_completion();
 
         pthread_mutex_unlock(&dma.lock);
         dma_thread_running = 0;
@@ -196,6 +217,7 @@ void *dma_perform_io(void *arg)
 
             dma.STATE = 1;
             dma.BUSY = 0;
+            dma_record_completion();
 
             pthread_mutex_unlock(&dma.lock);
             dma_thread_running = 0;
@@ -211,8 +233,8 @@ void *dma_perform_io(void *arg)
 
         write_log(0, "DMA: Formateado para disco. Cadena: \"%s\"\n", buffer);
 
-        // A.3 Escribir en disco
-        result = disk_write_sector(dma.TRACK, dma.CYLINDER, dma.SECTOR, buffer);
+        // A.3 Escribir en disco (a traves del buffer cache, write-back)
+        result = cache_write_sector(dma.TRACK, dma.CYLINDER, dma.SECTOR, buffer);
         if (result != 0)
         {
             write_log(1, "DMA: ERROR - Fallo al escribir en disco. PISTA=%d, CILINDRO=%d, SECTOR=%d\n",
@@ -220,6 +242,7 @@ void *dma_perform_io(void *arg)
 
             dma.STATE = 1;
             dma.BUSY = 0; // Liberar el DMA
+            dma_record_completion();
 
             pthread_mutex_unlock(&dma.lock);
             dma_thread_running = 0;
@@ -239,8 +262,8 @@ void *dma_perform_io(void *arg)
         // Inicializar buffer
         memset(buffer, 0, sizeof(buffer));
 
-        // B.1 Leer disco
-        result = disk_read_sector(dma.TRACK, dma.CYLINDER, dma.SECTOR, buffer);
+        // B.1 Leer disco (si el sector esta en el buffer cache no hay latencia)
+        result = cache_read_sector(dma.TRACK, dma.CYLINDER, dma.SECTOR, buffer, 1); // client_id = 1 (DMA)
         if (result != 0)
         {
             write_log(1, "DMA: ERROR - Fallo al leer del disco. PISTA=%d, CILINDRO=%d, SECTOR=%d\n",
@@ -248,6 +271,7 @@ void *dma_perform_io(void *arg)
 
             dma.STATE = 1;
             dma.BUSY = 0;
+            dma_record_completion();
 
             pthread_mutex_unlock(&dma.lock);
             dma_thread_running = 0;
@@ -271,6 +295,7 @@ void *dma_perform_io(void *arg)
 
             dma.STATE = 1;
             dma.BUSY = 0;
+            dma_record_completion();
 
             pthread_mutex_unlock(&dma.lock);
             dma_thread_running = 0;
@@ -286,6 +311,7 @@ void *dma_perform_io(void *arg)
 
     // 3. Completar operación y limpiar estado
     dma.BUSY = 0; // DMA ahora está libre para nuevas operaciones
+    dma_record_completion();
 
     // Liberar el mutex antes de enviar la interrupción (evita bloquear el mutex mientras se notifica a la CPU)
     pthread_mutex_unlock(&dma.lock);
@@ -320,6 +346,29 @@ int dma_get_state()
     return state;
 }
 
+int dma_take_completed(int *addresses, int max)
+{
+    pthread_mutex_lock(&dma.lock);
+    int taken = 0;
+    if (done_overflow)
+    {
+        taken = DMA_DONE_OVERFLOW;
+        done_overflow = 0;
+        done_count = 0;
+    }
+    else
+    {
+        while (taken < max && done_count > 0)
+        {
+            addresses[taken++] = done_addresses[done_head];
+            done_head = (done_head + 1) % DMA_DONE_QUEUE;
+            done_count--;
+        }
+    }
+    pthread_mutex_unlock(&dma.lock);
+    return taken;
+}
+
 int dma_is_busy()
 {
     if (!dma_initialized)
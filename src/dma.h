@@ -19,6 +19,19 @@ int dma_is_busy();
 // Devuelve el estado del DMA
 int dma_get_state();
 
+// Transferencias terminadas que todavía no se retiraron (con éxito o no)
+#define DMA_DONE_QUEUE 16
+#define DMA_DONE_OVERFLOW -1 // Se perdieron direcciones: hay que revisar todas
+
+/**
+ * Retira las direcciones físicas de las transferencias terminadas desde la última llamada
+ * (no depende de INT_IO_END, que se puede perder si hay otra interrupción pendiente).
+ *
+ * Retorna: cantidad copiada en addresses (a lo sumo max), o DMA_DONE_OVERFLOW si se
+ *          llenó la cola y alguna se perdió
+ */
+int dma_take_completed(int *addresses, int max);
+
 // Funcion que ejecutará el hilo que quiera usar el dma para su op de E/S 
 void *dma_perform_io(void *arg);
 
@@ -3,37 +3,182 @@
 #include "bus.h"
 #include "kernel.h"
 #include "log.h"
+#include "disk.h"
+#include "diskmap.h"
+#include "cache.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include "dma.h"
+#include "console.h"
+#include "shm.h"
+#include "pipe.h"
+#include "dma.h"
+
+static void file_table_reset();
+static void kernel_pipe_close(int pid, int pipe_id);
+static int pipe_ends_of(const PCB *pcb, int pipe_id);
+static void futex_unlink(int pid);
+static int futex_check_dma();
 
 // --- DEFINICIÓN DE VARIABLES GLOBALES ---
-PCB process_table[MAX_PROCESSES];
-FileTableEntry file_table[MAX_FILE_TABLE];
+PCB *process_table = NULL; // Crece a demanda (ver process_table_grow)
+PCBHot *process_hot = NULL;
+FileTableEntry *file_table = NULL; // Crece a demanda (ver ft_reserve)
 int file_table_count = 0;
 int current_pid = NULL_PID;
 int system_ticks = 0;
 bool partitions_bitmap[NUM_PARTITIONS];
 
+static int process_table_capacity = 0;
+
+// --- PIDS LIBRES ---
+// Cola FIFO circular: el PID que se libera es el último en reutilizarse,
+// así un PID recién terminado tarda en volver a aparecer
+static int *free_pids = NULL;
+static int fp_head = 0;
+static int fp_count = 0;
+
+// --- LISTA DE PROCESOS VIVOS ---
+static int live_head = NULL_PID;
+static int live_tail = NULL_PID;
+static int active_count = 0;     // Vivos que ya están en RAM (READY, RUNNING, BLOCKED)
+static int sleeping_count = 0;   // BLOCKED con wake_time pendiente (si es 0 el tic no busca a quién despertar)
+static int input_waiters = 0;    // BLOCKED esperando una línea de la consola
+static int pipe_waiters = 0;     // BLOCKED esperando que un tubo avance
+static int futex_waiters = 0;    // BLOCKED en la syscall 13
+
+// Colas de espera de la syscall 13, una por dirección física (FIFO, enlazadas por next_waiter)
+static int futex_head[MEM_SIZE];
+static int terminated_count = 0; // Procesos terminados desde el último reinicio
+
 // --- COLA DE LISTOS (READY QUEUE) ---
-int ready_queue[MAX_PROCESSES];
+// Circular, del tamaño de la tabla: un PID nunca está dos veces en la cola
+int *ready_queue = NULL;
 int rq_head = 0;
 int rq_aux = 0;
 int rq_count = 0;
 
-extern void dispatch(int nuevo_pid);
+extern CPU_Context context; // Registros de la CPU (definido en cpu.c)
 int kernel_pop_stack(int pid, int *value);
 
+/**
+ * Agranda la tabla de procesos (y las colas que dependen de su tamaño) al doble.
+ * Los PIDs nuevos entran al final de la cola de libres.
+ *
+ * Retorna: 0 si éxito, -1 si se llegó a MAX_PROCESSES o no hay memoria
+ */
+static int process_table_grow()
+{
+    int old_capacity = process_table_capacity;
+    int new_capacity = old_capacity > 0 ? old_capacity * 2 : PROCESS_TABLE_INITIAL_CAPACITY;
+    if (new_capacity > MAX_PROCESSES)
+        new_capacity = MAX_PROCESSES;
+    if (new_capacity <= old_capacity)
+        return -1;
+
+    PCB *table = realloc(process_table, sizeof(PCB) * new_capacity);
+    if (table == NULL)
+        return -1;
+    process_table = table;
+
+    PCBHot *hot = realloc(process_hot, sizeof(PCBHot) * new_capacity);
+    if (hot == NULL)
+        return -1;
+    process_hot = hot;
+
+    int *queue = malloc(sizeof(int) * new_capacity);
+    int *pids = malloc(sizeof(int) * new_capacity);
+    if (queue == NULL || pids == NULL)
+    {
+        free(queue);
+        free(pids);
+        return -1;
+    }
+
+    // Las colas circulares se copian en orden, empezando en 0
+    for (int i = 0; i < rq_count; i++)
+        queue[i] = ready_queue[(rq_head + i) % old_capacity];
+    for (int i = 0; i < fp_count; i++)
+        pids[i] = free_pids[(fp_head + i) % old_capacity];
+    free(ready_queue);
+    free(free_pids);
+    ready_queue = queue;
+    free_pids = pids;
+    rq_head = 0;
+    rq_aux = rq_count;
+    fp_head = 0;
+
+    for (int pid = old_capacity; pid < new_capacity; pid++)
+    {
+        process_table[pid].pid = -1;
+        process_hot[pid].state = STATE_TERMINATED;
+        process_table[pid].partition_id = -1;
+        free_pids[fp_count++] = pid;
+    }
+
+    process_table_capacity = new_capacity;
+    if (old_capacity > 0)
+        write_log(0, "KERNEL: Tabla de procesos ampliada a %d entradas.\n", new_capacity);
+    return 0;
+}
+
+// Saca un PID de la cola de libres (agrandando la tabla si hace falta). -1 si no hay
+static int alloc_pid()
+{
+    if (fp_count == 0 && process_table_grow() != 0)
+        return -1;
+
+    int pid = free_pids[fp_head];
+    fp_head = (fp_head + 1) % process_table_capacity;
+    fp_count--;
+    return pid;
+}
+
+static void release_pid(int pid)
+{
+    free_pids[(fp_head + fp_count) % process_table_capacity] = pid;
+    fp_count++;
+}
+
+static void live_link(int pid)
+{
+    process_hot[pid].prev_live = live_tail;
+    process_hot[pid].next_live = NULL_PID;
+    if (live_tail != NULL_PID)
+        process_hot[live_tail].next_live = pid;
+    else
+        live_head = pid;
+    live_tail = pid;
+}
+
+static void live_unlink(int pid)
+{
+    int prev = process_hot[pid].prev_live;
+    int next = process_hot[pid].next_live;
+    if (prev != NULL_PID)
+        process_hot[prev].next_live = next;
+    else
+        live_head = next;
+    if (next != NULL_PID)
+        process_hot[next].prev_live = prev;
+    else
+        live_tail = prev;
+}
+
 // Encola un proceso al final de la cola de listos
 void enqueue_ready(int pid)
 {
-    if (rq_count < MAX_PROCESSES)
+    if (rq_count < process_table_capacity)
     {
+        // Un proceso que sale de NEW acaba de entrar a RAM
+        if (process_hot[pid].state == STATE_NEW)
+            active_count++;
+
         ready_queue[rq_aux] = pid;
-        rq_aux = (rq_aux + 1) % MAX_PROCESSES;
+        rq_aux = (rq_aux + 1) % process_table_capacity;
         rq_count++;
-        process_table[pid].state = STATE_READY;
+        process_hot[pid].state = STATE_READY;
     }
     else
     {
@@ -44,40 +189,54 @@ void enqueue_ready(int pid)
 // Desencola el primer proceso de la cola de listos
 int dequeue_ready()
 {
-    if (rq_count == 0)
-        return NULL_PID;
+    while (rq_count > 0)
+    {
+        int pid = ready_queue[rq_head];
+        rq_head = (rq_head + 1) % process_table_capacity;
+        rq_count--;
 
-    int pid = ready_queue[rq_head];
-    rq_head = (rq_head + 1) % MAX_PROCESSES;
-    rq_count--;
-    return pid;
+        // Un proceso terminado mientras esperaba en la cola se descarta
+        if (process_hot[pid].state == STATE_READY)
+            return pid;
+    }
+    return NULL_PID;
 }
 
 // Inicializa todas las tablas y estructuras del kernel
 void kernel_init_structures()
 {
-    // Inicializar tabla de procesos
-    for (int i = 0; i < MAX_PROCESSES; i++)
+    // Inicializar tabla de procesos: todos los PIDs quedan libres, en orden
+    if (process_table_capacity == 0)
+        process_table_grow();
+
+    fp_head = 0;
+    fp_count = 0;
+    for (int i = 0; i < process_table_capacity; i++)
     {
         process_table[i].pid = -1;
-        process_table[i].state = STATE_TERMINATED;
+        process_hot[i].state = STATE_TERMINATED;
         process_table[i].partition_id = -1;
+        free_pids[fp_count++] = i;
     }
+    rq_head = rq_aux = rq_count = 0;
+    live_head = live_tail = NULL_PID;
+    active_count = 0;
+    sleeping_count = 0;
+    input_waiters = 0;
+    pipe_waiters = 0;
+    futex_waiters = 0;
+    for (int i = 0; i < MEM_SIZE; i++)
+        futex_head[i] = NULL_PID;
+    futex_check_dma(); // Descarta transferencias terminadas antes de reiniciar (no hay esperas)
+    terminated_count = 0;
 
     // Inicializar tabla de archivos
-    for (int i = 0; i < MAX_FILE_TABLE; i++)
-    {
-        file_table[i].program_name[0] = '\0';
-        file_table[i].pid = -1;
-        file_table[i].partition_id = -1;
-        file_table[i].state = FILE_STATE_DISK;
-        file_table[i].track = -1;
-        file_table[i].cylinder = -1;
-        file_table[i].sector_initial = -1;
-        file_table[i].size_words = 0;
-        file_table[i].n_start = 0;
-    }
-    file_table_count = 0;
+    file_table_reset();
+
+    // Recuperar los programas que ya estaban en la imagen del disco
+    // (el mapa de sectores libres se reconstruye a partir de sus extensiones)
+    diskmap_reset();
+    file_table_restore();
 
     // Inicializar particiones como libres
     for (int i = 0; i < NUM_PARTITIONS; i++)
@@ -87,6 +246,8 @@ void kernel_init_structures()
 
     current_pid = NULL_PID;
     system_ticks = 0;
+    shm_init();
+    pipe_init();
 
     write_log(0, "KERNEL: Estructuras inicializadas (Procesos, Archivos, Memoria).\n");
 }
@@ -94,6 +255,127 @@ void kernel_init_structures()
 // ============================================================
 // === FUNCIONES DE GESTIÓN DE TABLA DE ARCHIVOS ===
 // ============================================================
+//
+// La tabla es un arreglo que crece al doble cuando se llena.
+// Las búsquedas no la recorren:
+//   - Por nombre: índice hash con direccionamiento abierto (sondeo lineal).
+//     Cada casilla guarda el índice de la entrada, FT_SLOT_EMPTY o FT_SLOT_DELETED.
+//   - Por PID: mapa inverso PID -> índice de la entrada.
+
+#define FT_SLOT_EMPTY -1
+#define FT_SLOT_DELETED -2 // Lápida: la búsqueda sigue de largo, la inserción la reutiliza
+
+static int file_table_capacity = 0;
+
+static int *ft_name_slots = NULL;
+static int ft_name_size = 0; // Siempre potencia de 2
+static int ft_name_used = 0; // Casillas ocupadas + lápidas
+
+static int *ft_pid_map = NULL;
+static int ft_pid_map_size = 0;
+
+// Hash FNV-1a del nombre del programa
+static unsigned int ft_hash_name(const char *name)
+{
+    unsigned int hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Retorna la casilla del índice que apunta a la entrada con ese nombre, o -1
+static int ft_name_find_slot(const char *program_name)
+{
+    if (ft_name_size == 0)
+        return -1;
+
+    unsigned int mask = (unsigned int)ft_name_size - 1;
+    for (unsigned int slot = ft_hash_name(program_name) & mask;; slot = (slot + 1) & mask)
+    {
+        int index = ft_name_slots[slot];
+        if (index == FT_SLOT_EMPTY)
+            return -1;
+        if (index >= 0 && strcmp(file_table[index].program_name, program_name) == 0)
+            return (int)slot;
+    }
+}
+
+static void ft_name_insert(int index)
+{
+    unsigned int mask = (unsigned int)ft_name_size - 1;
+    unsigned int slot = ft_hash_name(file_table[index].program_name) & mask;
+    while (ft_name_slots[slot] >= 0)
+        slot = (slot + 1) & mask;
+
+    if (ft_name_slots[slot] == FT_SLOT_EMPTY)
+        ft_name_used++;
+    ft_name_slots[slot] = index;
+}
+
+// Rehace el índice por nombre con el tamaño dado (descarta las lápidas)
+static int ft_name_rebuild(int size)
+{
+    int *slots = malloc(sizeof(int) * size);
+    if (slots == NULL)
+        return -1;
+
+    free(ft_name_slots);
+    ft_name_slots = slots;
+    ft_name_size = size;
+    ft_name_used = 0;
+    for (int i = 0; i < size; i++)
+        ft_name_slots[i] = FT_SLOT_EMPTY;
+
+    for (int i = 0; i < file_table_count; i++)
+        ft_name_insert(i);
+    return 0;
+}
+
+/**
+ * Garantiza espacio para `needed` entradas: agranda el arreglo y,
+ * si el índice por nombre pasa del 70% de ocupación (lápidas incluidas), lo rehace.
+ *
+ * Retorna: 0 si éxito, -1 si no hay memoria
+ */
+static int ft_reserve(int needed)
+{
+    if (needed > file_table_capacity)
+    {
+        int new_capacity = file_table_capacity > 0 ? file_table_capacity : FILE_TABLE_INITIAL_CAPACITY;
+        while (new_capacity < needed)
+            new_capacity *= 2;
+
+        FileTableEntry *grown = realloc(file_table, sizeof(FileTableEntry) * new_capacity);
+        if (grown == NULL)
+            return -1;
+        file_table = grown;
+        file_table_capacity = new_capacity;
+    }
+
+    if ((ft_name_used + 1) * 10 > ft_name_size * 7 || needed * 10 > ft_name_size * 7)
+    {
+        int new_size = 16;
+        while (new_size * 7 < needed * 2 * 10)
+            new_size *= 2;
+        if (ft_name_rebuild(new_size) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+// Vacía la tabla conservando la memoria ya reservada
+static void file_table_reset()
+{
+    file_table_count = 0;
+    ft_name_used = 0;
+    for (int i = 0; i < ft_name_size; i++)
+        ft_name_slots[i] = FT_SLOT_EMPTY;
+    for (int i = 0; i < ft_pid_map_size; i++)
+        ft_pid_map[i] = -1;
+}
 
 /**
  * Busca un programa en la tabla de archivos por nombre
@@ -106,16 +388,8 @@ void kernel_init_structures()
  */
 int file_table_search_by_name(const char *program_name)
 {
-    for (int i = 0; i < file_table_count; i++)
-    {
-        if (strcmp(file_table[i].program_name, program_name) == 0)
-        {
-            write_log(0, "FILE TABLE: Programa '%s' encontrado en índice %d.\n", program_name, i);
-            return i;
-        }
-    }
-    write_log(0, "FILE TABLE: Programa '%s' NO encontrado.\n", program_name);
-    return -1;
+    int slot = ft_name_find_slot(program_name);
+    return slot < 0 ? -1 : ft_name_slots[slot];
 }
 
 /**
@@ -130,15 +404,68 @@ int file_table_search_by_name(const char *program_name)
  */
 int file_table_find_by_pid(int pid)
 {
-    for (int i = 0; i < file_table_count; i++)
+    if (pid < 0 || pid >= ft_pid_map_size)
+        return -1;
+    return ft_pid_map[pid];
+}
+
+/**
+ * Asocia un PID a una entrada (pid = -1 la desasocia) y mantiene el mapa inverso.
+ * Si el PID estaba asociado a otra entrada (PID reutilizado) esa entrada lo pierde.
+ */
+void file_table_set_pid(int index, int pid)
+{
+    FileTableEntry *entry = get_file_table_entry(index);
+    if (entry == NULL)
+        return;
+
+    if (entry->pid >= 0 && entry->pid < ft_pid_map_size && ft_pid_map[entry->pid] == index)
+        ft_pid_map[entry->pid] = -1;
+    entry->pid = pid;
+    if (pid < 0)
+        return;
+
+    if (pid >= ft_pid_map_size)
     {
-        if (file_table[i].pid == pid)
+        int new_size = ft_pid_map_size > 0 ? ft_pid_map_size : FILE_TABLE_INITIAL_CAPACITY;
+        while (new_size <= pid)
+            new_size *= 2;
+
+        int *grown = realloc(ft_pid_map, sizeof(int) * new_size);
+        if (grown == NULL)
         {
-            write_log(0, "FILE TABLE: Archivo con PID %d encontrado en índice %d.\n", pid, i);
-            return i;
+            write_log(1, "FILE TABLE ERROR: Sin memoria para el mapa de PIDs.\n");
+            return;
         }
+        for (int i = ft_pid_map_size; i < new_size; i++)
+            grown[i] = -1;
+        ft_pid_map = grown;
+        ft_pid_map_size = new_size;
+    }
+
+    int previous = ft_pid_map[pid];
+    if (previous >= 0 && previous != index)
+        file_table[previous].pid = -1;
+    ft_pid_map[pid] = index;
+}
+
+/**
+ * Busca un programa cuyo contenido tenga el mismo hash y tamaño.
+ * Permite que dos nombres con el mismo archivo compartan la imagen en disco.
+ * Sólo se usa al cargar desde la PC real, que ya es O(palabras), así que es lineal.
+ *
+ * Retorna: índice en file_table, o -1 si no hay ninguno
+ */
+int file_table_find_by_hash(uint64_t hash, int size)
+{
+    if (hash == 0)
+        return -1;
+
+    for (int i = 0; i < file_table_count; i++)
+    {
+        if (file_table[i].content_hash == hash && file_table[i].size_words == size)
+            return i;
     }
-    write_log(0, "FILE TABLE: NO hay archivo con PID %d.\n", pid);
     return -1;
 }
 
@@ -161,6 +488,7 @@ FileTableEntry *get_file_table_entry(int index)
 /**
  * Agrega un nuevo programa a la tabla de archivos.
  * Se llama desde load_program después de escribir en disco.
+ * Falla si el nombre ya existe.
  *
  * Parámetros:
  *   - program_name: nombre del programa (ej: "prog1.txt")
@@ -172,17 +500,16 @@ FileTableEntry *get_file_table_entry(int index)
  */
 int file_table_add_entry(const char *program_name, int track, int cylinder, int sector, int size, int n_start)
 {
-    // Validar que la tabla no esté llena
-    if (file_table_count >= MAX_FILE_TABLE)
+    // Verificar que no exista un programa con el mismo nombre
+    if (file_table_search_by_name(program_name) != -1)
     {
-        write_log(1, "FILE TABLE ERROR: Tabla llena. No se puede agregar '%s'.\n", program_name);
+        write_log(1, "FILE TABLE ERROR: Programa '%s' ya existe.\n", program_name);
         return -1;
     }
 
-    // Verificar que no exista un programa con el mismo nombre
-    if (file_table_search_by_name(program_name) != -1)
+    if (ft_reserve(file_table_count + 1) != 0)
     {
-        write_log(1, "FILE TABLE ERROR: Programa '%s' ya existe.\n", program_name);
+        write_log(1, "FILE TABLE ERROR: Sin memoria. No se puede agregar '%s'.\n", program_name);
         return -1;
     }
 
@@ -200,167 +527,1175 @@ int file_table_add_entry(const char *program_name, int track, int cylinder, int
     entry->pid = -1;                // Sin PID aún (en disco)
     entry->partition_id = -1;       // Sin partición aún (en disco)
     entry->state = FILE_STATE_DISK; // Estado inicial: en disco
+    entry->content_hash = 0;        // Lo completa el cargador
+    entry->source_mtime = 0;
+    entry->source_size = 0;
+    entry->abi = ABI_STACK;
 
     write_log(0, "FILE TABLE: Entrada %d agregada: '%s' [Track=%d, Cyl=%d, Sec=%d, Size=%d, n_start=%d]\n",
               file_table_count, program_name, track, cylinder, sector, size, n_start);
 
+    ft_name_insert(file_table_count);
     file_table_count++;
+    file_table_save();
     return file_table_count - 1;
 }
 
-// Crea un PCB básico para un nuevo proceso (Estado NEW en disco)
-
-int create_process(const char *name, int track, int cylinder, int sector, int size)
+/**
+ * Elimina un programa de la tabla de archivos y libera sus sectores en disco.
+ * No se permite si el programa tiene un proceso vivo en RAM.
+ * La última entrada pasa a ocupar el hueco, así que los índices de otras
+ * entradas pueden cambiar (los de la última).
+ *
+ * Retorna: 0 si éxito, -1 si error
+ */
+int file_table_remove(int index)
 {
-    int free_slot = -1;
+    FileTableEntry *entry = get_file_table_entry(index);
+    if (entry == NULL)
+        return -1;
 
-    for (int i = 0; i < MAX_PROCESSES; i++)
+    if (entry->pid != -1)
     {
-        if (process_table[i].pid == -1 || process_table[i].state == STATE_TERMINATED)
+        PCB *pcb = get_pcb(entry->pid);
+        if (pcb != NULL && process_hot[entry->pid].state != STATE_TERMINATED)
         {
-            free_slot = i;
-            break;
+            write_log(1, "FILE TABLE ERROR: '%s' está en uso por el PID %d.\n", entry->program_name, entry->pid);
+            return -1;
         }
     }
 
-    if (free_slot == -1)
+    // Los sectores sólo se liberan si ningún otro nombre comparte la misma imagen
+    bool shared = false;
+    for (int i = 0; i < file_table_count; i++)
     {
-        write_log(1, "KERNEL ERROR: Tabla de procesos llena. No se puede crear '%s'.\n", name);
-        return -1;
+        if (i != index && file_table[i].track == entry->track && file_table[i].cylinder == entry->cylinder &&
+            file_table[i].sector_initial == entry->sector_initial && file_table[i].size_words > 0)
+        {
+            shared = true;
+            break;
+        }
     }
+    if (!shared)
+        diskmap_free(disk_to_lba(entry->track, entry->cylinder, entry->sector_initial), entry->size_words);
+    write_log(0, "FILE TABLE: Entrada %d ('%s') eliminada.\n", index, entry->program_name);
 
-    PCB *new_proc = &process_table[free_slot];
+    // Quitar la entrada de los índices
+    file_table_set_pid(index, -1);
+    ft_name_slots[ft_name_find_slot(entry->program_name)] = FT_SLOT_DELETED;
 
-    new_proc->pid = free_slot;
-    strncpy(new_proc->name, name, 49);
-    new_proc->state = STATE_NEW;
+    // Mover la última entrada al hueco y corregir sus índices
+    int last = file_table_count - 1;
+    if (index != last)
+    {
+        int last_slot = ft_name_find_slot(file_table[last].program_name);
+        file_table[index] = file_table[last];
+        ft_name_slots[last_slot] = index;
+        if (file_table[index].pid >= 0 && file_table[index].pid < ft_pid_map_size)
+            ft_pid_map[file_table[index].pid] = index;
+    }
+    file_table_count--;
+    file_table_save();
+    return 0;
+}
 
-    new_proc->disk_track = track;
-    new_proc->disk_cylinder = cylinder;
-    new_proc->disk_sector = sector;
-    new_proc->prog_size = size;
+// Formato de la tabla en el disco: las primeras entradas van en la región de metadatos
+// y las que no caben, en una extensión de sectores reservada con diskmap_alloc
+// (anotada en la cabecera), así la tabla guardada crece igual que la de RAM
+#define FILE_TABLE_MAGIC 0x46544234 // "FTB4": cambia si cambia FileTableEntry o este formato
 
-    new_proc->partition_id = -1;
+typedef struct
+{
+    uint32_t magic;
+    int count;            // Entradas totales (región de metadatos + extensión)
+    int overflow_lba;     // Primer sector de la extensión, -1 si no hay
+    int overflow_sectors; // Sectores reservados para la extensión
+    FileTableEntry entries[];
+} FileTableImage;
 
-    memset(&new_proc->context, 0, sizeof(CPU_Context));
+// Extensión de desborde en uso (la que anota la cabecera)
+static int ft_overflow_lba = -1;
+static int ft_overflow_sectors = 0;
 
-    write_log(0, "KERNEL: Proceso creado PID=%d, (%s) en estado NEW.\n", free_slot, name);
-    return free_slot;
+// Cantidad de entradas que caben en la región de metadatos
+static int file_table_image_capacity(size_t meta_size)
+{
+    if (meta_size < sizeof(FileTableImage))
+        return 0;
+    return (int)((meta_size - sizeof(FileTableImage)) / sizeof(FileTableEntry));
 }
 
-// Obtiene el PCB de un proceso
-PCB *get_pcb(int pid)
+// Sectores que ocupan `count` entradas guardadas byte a byte
+static int ft_overflow_sectors_for(int count)
 {
-    if (pid < 0 || pid >= MAX_PROCESSES)
-        return NULL;
-    if (process_table[pid].pid == -1)
-        return NULL;
-    return &process_table[pid];
+    size_t bytes = sizeof(FileTableEntry) * (size_t)count;
+    return (int)((bytes + SECTOR_BYTES - 1) / SECTOR_BYTES);
 }
 
 /**
- * Encuentra una partición de RAM libre
- * Retorna: ID de partición (0-4), o -1 si todas están ocupadas
+ * Copia `count` entradas a partir de file_table[first] en la extensión de desborde,
+ * reservando una más grande si la actual no alcanza (el doble, para no moverla en cada alta).
+ *
+ * Retorna: 0 si éxito, -1 si no hay espacio en el disco o falla la escritura
  */
-int find_free_partition()
+static int ft_overflow_write(int first, int count)
 {
-    for (int i = 0; i < NUM_PARTITIONS; i++)
+    int needed = ft_overflow_sectors_for(count);
+    if (needed == 0)
     {
-        if (!partitions_bitmap[i])
+        if (ft_overflow_lba != -1)
+            diskmap_free(ft_overflow_lba, ft_overflow_sectors);
+        ft_overflow_lba = -1;
+        ft_overflow_sectors = 0;
+        return 0;
+    }
+
+    if (needed > ft_overflow_sectors)
+    {
+        int size = needed * 2;
+        int lba = diskmap_alloc(size);
+        if (lba == -1)
         {
-            partitions_bitmap[i] = true; // Marcar como OCUPADA
-            write_log(0, "KERNEL: Partición %d está libre.\n", i);
-            return i;
+            size = needed;
+            lba = diskmap_alloc(size);
         }
+        if (lba == -1)
+        {
+            write_log(1, "FILE TABLE ERROR: No hay %d sectores contiguos libres para la tabla de archivos.\n", needed);
+            return -1;
+        }
+        if (ft_overflow_lba != -1)
+            diskmap_free(ft_overflow_lba, ft_overflow_sectors);
+        ft_overflow_lba = lba;
+        ft_overflow_sectors = size;
     }
-    write_log(1, "KERNEL ERROR: Todas las particiones están ocupadas.\n");
-    return -1;
-}
 
-const char *state_to_string(ProcessState s)
-{
-    switch (s)
+    const unsigned char *bytes = (const unsigned char *)&file_table[first];
+    size_t total = sizeof(FileTableEntry) * (size_t)count;
+    for (int i = 0; i < needed; i++)
     {
-    case STATE_NEW:
-        return "NEW";
-    case STATE_READY:
-        return "READY";
-    case STATE_RUNNING:
-        return "RUNNING";
-    case STATE_BLOCKED:
-        return "BLOCKED";
-    case STATE_TERMINATED:
-        return "TERMINATED";
-    default:
-        return "UNKNOWN";
+        char buffer[SECTOR_BYTES] = {0};
+        size_t offset = (size_t)i * SECTOR_BYTES;
+        size_t chunk = total - offset < SECTOR_BYTES ? total - offset : SECTOR_BYTES;
+        memcpy(buffer, bytes + offset, chunk);
+
+        int track, cylinder, sector;
+        disk_from_lba(ft_overflow_lba + i, &track, &cylinder, &sector);
+        if (cache_write_sector(track, cylinder, sector, buffer) != 0)
+            return -1;
     }
+    return 0;
 }
 
-void schedule()
+/**
+ * Guarda la tabla de archivos en el disco (región de metadatos y, si hace falta,
+ * la extensión de desborde), así los programas cargados sobreviven a reiniciar
+ * o apagar el simulador.
+ *
+ * Retorna: 0 si éxito, -1 si error
+ */
+int file_table_save()
 {
-    int outgoing_pid = current_pid;
+    size_t meta_size;
+    FileTableImage *img = (FileTableImage *)disk_get_metadata(&meta_size);
+    int capacity = file_table_image_capacity(meta_size);
+    if (img == NULL || capacity == 0)
+    {
+        write_log(1, "FILE TABLE ERROR: No hay región de metadatos en disco.\n");
+        return -1;
+    }
 
-    if (outgoing_pid != NULL_PID)
+    int in_meta = file_table_count < capacity ? file_table_count : capacity;
+    int count = file_table_count;
+    if (ft_overflow_write(in_meta, file_table_count - in_meta) != 0)
     {
-        if (process_table[outgoing_pid].state == STATE_RUNNING)
-        {
-            enqueue_ready(outgoing_pid);
-        }
+        write_log(1, "FILE TABLE: Sólo %d de %d programas quedan guardados en el disco.\n", in_meta, file_table_count);
+        count = in_meta;
     }
 
-    int incoming_pid = dequeue_ready();
+    img->magic = FILE_TABLE_MAGIC;
+    img->count = count;
+    img->overflow_lba = ft_overflow_lba;
+    img->overflow_sectors = ft_overflow_sectors;
+    memcpy(img->entries, file_table, sizeof(FileTableEntry) * in_meta);
+    return count == file_table_count ? 0 : -1;
+}
 
-    if (incoming_pid == NULL_PID)
+// Agrega una entrada recuperada del disco (sin PID ni partición) y marca sus sectores
+static void ft_restore_entry(const FileTableEntry *saved)
+{
+    FileTableEntry *entry = &file_table[file_table_count];
+    *entry = *saved;
+    entry->program_name[49] = '\0';
+    entry->pid = -1;
+    entry->partition_id = -1;
+    entry->state = FILE_STATE_DISK;
+
+    if (file_table_search_by_name(entry->program_name) != -1)
+        return; // Imagen dañada: nombre repetido
+    ft_name_insert(file_table_count);
+    file_table_count++;
+
+    diskmap_mark_used(disk_to_lba(entry->track, entry->cylinder, entry->sector_initial), entry->size_words);
+}
+
+/**
+ * Recupera la tabla de archivos desde la imagen del disco.
+ * Los datos de ejecución (PID, partición) no se conservan: todo queda en estado DISK.
+ *
+ * Retorna: cantidad de programas recuperados
+ */
+int file_table_restore()
+{
+    ft_overflow_lba = -1;
+    ft_overflow_sectors = 0;
+
+    size_t meta_size;
+    FileTableImage *img = (FileTableImage *)disk_get_metadata(&meta_size);
+    if (img == NULL || img->magic != FILE_TABLE_MAGIC || img->count <= 0)
+        return 0;
+
+    int capacity = file_table_image_capacity(meta_size);
+    int in_meta = img->count < capacity ? img->count : capacity;
+    int extra = img->count - in_meta;
+    if (extra > 0 && (img->overflow_lba < 0 || img->overflow_sectors < ft_overflow_sectors_for(extra) ||
+                      img->overflow_lba + img->overflow_sectors > DISK_TOTAL_SECTORS))
+        return 0;
+
+    if (ft_reserve(img->count) != 0)
+        return 0;
+
+    for (int i = 0; i < in_meta; i++)
+        ft_restore_entry(&img->entries[i]);
+
+    if (extra > 0)
     {
-        if (outgoing_pid != NULL_PID && process_table[outgoing_pid].state == STATE_READY)
+        // Se lee la extensión completa a un buffer y se recorren sus entradas
+        int sectors = ft_overflow_sectors_for(extra);
+        unsigned char *bytes = malloc((size_t)sectors * SECTOR_BYTES);
+        if (bytes == NULL)
+            return file_table_count;
+        for (int i = 0; i < sectors; i++)
         {
-            incoming_pid = dequeue_ready();
+            int track, cylinder, sector;
+            disk_from_lba(img->overflow_lba + i, &track, &cylinder, &sector);
+            if (cache_read_sector(track, cylinder, sector, (char *)bytes + (size_t)i * SECTOR_BYTES, 3) != 0)
+            {
+                write_log(1, "FILE TABLE ERROR: No se pudo leer la extensión de la tabla (sector %d).\n",
+                          img->overflow_lba + i);
+                extra = 0;
+                break;
+            }
         }
-        else
+        for (int i = 0; i < extra; i++)
         {
-            current_pid = NULL_PID;
-            return;
+            FileTableEntry saved;
+            memcpy(&saved, bytes + sizeof(FileTableEntry) * (size_t)i, sizeof(saved));
+            ft_restore_entry(&saved);
         }
-    }
+        free(bytes);
 
-    if (outgoing_pid != incoming_pid && outgoing_pid != NULL_PID)
-    {
-        write_log(0, "PLANIFICADOR: Quantum agotado. Sale PID %d (%s), Entra PID %d (%s)\n",
-                  outgoing_pid, process_table[outgoing_pid].name,
-                  incoming_pid, process_table[incoming_pid].name);
+        ft_overflow_lba = img->overflow_lba;
+        ft_overflow_sectors = img->overflow_sectors;
+        diskmap_mark_used(ft_overflow_lba, ft_overflow_sectors);
     }
 
-    process_table[incoming_pid].quantum_counter = 0;
-    dispatch(incoming_pid);
+    write_log(0, "FILE TABLE: %d programa(s) recuperados desde la imagen del disco.\n", file_table_count);
+    return file_table_count;
 }
 
-void kernel_handle_interrupt(int interrupt_code)
-{
-    if (current_pid == NULL_PID)
-        return;
+// Crea un PCB básico para un nuevo proceso (Estado NEW en disco)
 
-    if (interrupt_code == INT_CLOCK)
+int create_process(const char *name, int track, int cylinder, int sector, int size)
+{
+    int free_slot = alloc_pid();
+
+    if (free_slot == -1)
     {
-        system_ticks++;
+        write_log(1, "KERNEL ERROR: Tabla de procesos llena. No se puede crear '%s'.\n", name);
+        return -1;
+    }
+
+    PCB *new_proc = &process_table[free_slot];
+    PCBHot *hot = &process_hot[free_slot];
+
+    new_proc->pid = free_slot;
+    strncpy(new_proc->name, name, 49);
+    new_proc->name[49] = '\0';
+    hot->state = STATE_NEW;
+
+    new_proc->disk_track = track;
+    new_proc->disk_cylinder = cylinder;
+    new_proc->disk_sector = sector;
+    new_proc->prog_size = size;
+
+    new_proc->partition_id = -1;
+    hot->quantum_counter = 0;
+    hot->wake_time = 0;
+    hot->wait_reason = WAIT_NONE;
+    new_proc->input_prompted = 0;
+    new_proc->abi = ABI_STACK; // La define la tabla de archivos al cargarlo en RAM
+    new_proc->shm_id = -1;
+    new_proc->pipe_read_mask = 0;
+    new_proc->pipe_write_mask = 0;
+    hot->wait_object = 0;
+    hot->next_waiter = NULL_PID;
+
+    memset(&new_proc->context, 0, sizeof(CPU_Context));
+    live_link(free_slot);
+    console_output_open(free_slot, new_proc->name);
+
+    write_log(0, "KERNEL: Proceso creado PID=%d, (%s) en estado NEW.\n", free_slot, name);
+    return free_slot;
+}
+
+// Obtiene el PCB de un proceso
+PCB *get_pcb(int pid)
+{
+    if (pid < 0 || pid >= process_table_capacity)
+        return NULL;
+    if (process_table[pid].pid == -1)
+        return NULL;
+    return &process_table[pid];
+}
+
+/**
+ * Contexto de un proceso. El del proceso en ejecución vive en la CPU
+ * (el PCB está desactualizado hasta que salga), el de los demás en su PCB.
+ */
+CPU_Context *process_context(int pid)
+{
+    if (pid == current_pid && pid != NULL_PID)
+        return &context;
+    return &process_table[pid].context;
+}
+
+// Obtiene los datos calientes (estado, quantum, despertar) de un proceso
+PCBHot *get_pcb_hot(int pid)
+{
+    if (get_pcb(pid) == NULL)
+        return NULL;
+    return &process_hot[pid];
+}
+
+/**
+ * Termina un proceso: lo pasa a TERMINATED, libera su partición y devuelve su PID
+ * a la cola de libres. El PCB se conserva (para PS) hasta que el PID se reutilice.
+ * No planifica: si era el proceso actual, quien llama debe invocar schedule().
+ */
+void kernel_terminate_process(int pid)
+{
+    PCB *pcb = get_pcb(pid);
+    if (pcb == NULL || process_hot[pid].state == STATE_TERMINATED)
+        return;
+
+    PCBHot *hot = &process_hot[pid];
+    if (hot->state == STATE_BLOCKED && hot->wait_reason == WAIT_SLEEP)
+        sleeping_count--;
+    if (hot->state == STATE_BLOCKED && hot->wait_reason == WAIT_INPUT)
+        input_waiters--;
+    if (hot->state == STATE_BLOCKED && hot->wait_reason == WAIT_PIPE)
+        pipe_waiters--;
+    if (hot->state == STATE_BLOCKED && hot->wait_reason == WAIT_FUTEX)
+        futex_unlink(pid);
+    hot->wait_reason = WAIT_NONE;
+    if (hot->state != STATE_NEW)
+        active_count--;
+    hot->state = STATE_TERMINATED;
+
+    if (pcb->partition_id != -1)
+    {
+        partitions_bitmap[pcb->partition_id] = false;
+    }
+
+    int file_index = file_table_find_by_pid(pid);
+    if (file_index != -1)
+    {
+        file_table[file_index].state = FILE_STATE_TERMINATED;
+        file_table[file_index].partition_id = -1;
+    }
+
+    if (pcb->shm_id != -1)
+    {
+        shm_release(pcb->shm_id);
+        pcb->shm_id = -1;
+    }
+
+    for (int i = 0; i < PIPE_MAX; i++)
+    {
+        if (pipe_ends_of(pcb, i) != 0)
+            kernel_pipe_close(pid, i);
+    }
+
+    console_output_close(pid); // Lo que quedó en su buffer sale ahora
+    live_unlink(pid);
+    release_pid(pid);
+    terminated_count++;
+}
+
+int kernel_first_process()
+{
+    return live_head;
+}
+
+int kernel_next_process(int pid)
+{
+    return get_pcb(pid) == NULL ? NULL_PID : process_hot[pid].next_live;
+}
+
+int kernel_active_count()
+{
+    return active_count;
+}
+
+// Procesos terminados desde el último reinicio (ya no aparecen en la lista de vivos)
+int kernel_terminated_count()
+{
+    return terminated_count;
+}
+
+/**
+ * Encuentra una partición de RAM libre
+ * Retorna: ID de partición (0-4), o -1 si todas están ocupadas
+ */
+int find_free_partition()
+{
+    for (int i = 0; i < NUM_PARTITIONS; i++)
+    {
+        if (!partitions_bitmap[i])
+        {
+            partitions_bitmap[i] = true; // Marcar como OCUPADA
+            write_log(0, "KERNEL: Partición %d está libre.\n", i);
+            return i;
+        }
+    }
+    write_log(1, "KERNEL ERROR: Todas las particiones están ocupadas.\n");
+    return -1;
+}
+
+const char *state_to_string(ProcessState s)
+{
+    switch (s)
+    {
+    case STATE_NEW:
+        return "NEW";
+    case STATE_READY:
+        return "READY";
+    case STATE_RUNNING:
+        return "RUNNING";
+    case STATE_BLOCKED:
+        return "BLOCKED";
+    case STATE_TERMINATED:
+        return "TERMINATED";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+void schedule()
+{
+    int outgoing_pid = current_pid;
+
+    if (outgoing_pid != NULL_PID)
+    {
+        if (process_hot[outgoing_pid].state == STATE_RUNNING)
+        {
+            enqueue_ready(outgoing_pid);
+        }
+    }
+
+    int incoming_pid = dequeue_ready();
+
+    if (incoming_pid == NULL_PID)
+    {
+        if (outgoing_pid != NULL_PID && process_hot[outgoing_pid].state == STATE_READY)
+        {
+            incoming_pid = dequeue_ready();
+        }
+        else
+        {
+            dispatch(NULL_PID); // Salva el contexto del que se durmió y deja la CPU libre
+            return;
+        }
+    }
+
+    if (outgoing_pid != incoming_pid && outgoing_pid != NULL_PID)
+    {
+        write_log(0, "PLANIFICADOR: Quantum agotado. Sale PID %d (%s), Entra PID %d (%s)\n",
+                  outgoing_pid, process_table[outgoing_pid].name,
+                  incoming_pid, process_table[incoming_pid].name);
+    }
+
+    process_hot[incoming_pid].quantum_counter = 0;
+    dispatch(incoming_pid);
+}
+
+// ============================================================
+// === LLAMADAS AL SISTEMA ===
+// ============================================================
+
+// Resultado de atender una llamada al sistema
+typedef enum
+{
+    SYSCALL_DONE,    // Atendida, el proceso sigue
+    SYSCALL_BLOCKED, // Atendida, pero el proceso quedó BLOCKED (hay que planificar)
+    SYSCALL_RETRY,   // No se pudo atender todavía: el proceso quedó BLOCKED y la reintenta al despertar
+    SYSCALL_EXITED   // El proceso terminó (hay que planificar)
+} SyscallStatus;
+
+/**
+ * SYSCALL 3: leer un entero de la consola.
+ * No espera al teclado: si todavía no hay línea, el proceso queda BLOCKED (WAIT_INPUT)
+ * y se devuelve SYSCALL_RETRY; quien llama deja el PC otra vez sobre el SVC.
+ */
+static SyscallStatus kernel_syscall_read(int pid, int *value)
+{
+    PCB *pcb = get_pcb(pid);
+    if (!pcb->input_prompted)
+    {
+        console_output_flush_all(); // Lo impreso antes de pedir la entrada tiene que verse
+        printf("\n[ENTRADA %d]> Ingrese un entero (o teclee 'memestat' / 'ps' / 'ipcs'): ", pid);
+        fflush(stdout);
+        pcb->input_prompted = 1;
+    }
+
+    char input_str[CONSOLE_LINE_MAX];
+    int got;
+    while ((got = console_try_read_input(input_str, sizeof(input_str))) == 1)
+    {
+        char token[50] = "";
+        sscanf(input_str, "%49s", token);
+        if (token[0] == '\0')
+            continue; // Línea vacía
+
+        if (strcmp(token, "ps") == 0)
+        {
+            extern void cmd_ps();
+            cmd_ps();
+            printf("\n[ENTRADA %d]> Ingrese un entero: ", pid);
+            fflush(stdout);
+        }
+        else if (strcmp(token, "memestat") == 0)
+        {
+            extern void cmd_memestat();
+            cmd_memestat();
+            printf("\n[ENTRADA %d]> Ingrese un entero: ", pid);
+            fflush(stdout);
+        }
+        else if (strcmp(token, "ipcs") == 0)
+        {
+            extern void cmd_ipcs();
+            cmd_ipcs();
+            printf("\n[ENTRADA %d]> Ingrese un entero: ", pid);
+            fflush(stdout);
+        }
+        else
+        {
+            // Si no es un comando de auditoría, asumimos que es un numero
+            *value = atoi(token);
+            pcb->input_prompted = 0;
+            write_log(0, "SYSCALL 3: Proceso %d leyó %d.\n", pid, *value);
+            return SYSCALL_DONE;
+        }
+    }
+
+    if (got < 0)
+    {
+        // No va a llegar más entrada: se entrega 0 para que el proceso no quede colgado
+        *value = 0;
+        pcb->input_prompted = 0;
+        write_log(1, "SYSCALL 3: Fin de la entrada. Proceso %d recibe 0.\n", pid);
+        return SYSCALL_DONE;
+    }
+
+    // Sin línea todavía: bloquear hasta que la consola tenga algo
+    write_log(0, "SYSCALL 3: Proceso %d espera entrada. Pasa a BLOQUEADO.\n", pid);
+    process_hot[pid].state = STATE_BLOCKED;
+    process_hot[pid].wait_reason = WAIT_INPUT;
+    input_waiters++;
+    return SYSCALL_RETRY;
+}
+
+// Traduce una dirección lógica del proceso como la MMU (partición o segmento compartido), -1 si es inválida
+static int user_translate(int pid, int logical_addr)
+{
+    CPU_Context *ctx = process_context(pid);
+    if (ctx->SL > 0 && logical_addr >= SHM_LOGICAL_BASE && logical_addr < SHM_LOGICAL_BASE + ctx->SL)
+        return ctx->SB + (logical_addr - SHM_LOGICAL_BASE);
+
+    int phys = ctx->RB + logical_addr;
+    if (logical_addr < 0 || phys > ctx->RL)
+        return -1;
+    return phys;
+}
+
+// Lee una palabra del proceso (sin convertir) en una dirección lógica. Retorna 0 si éxito
+static int user_read_word(int pid, int logical_addr, Word *raw)
+{
+    int phys = user_translate(pid, logical_addr);
+    if (phys == -1)
+        return -1;
+    return bus_read(phys, raw, 0);
+}
+
+static int user_write_word(int pid, int logical_addr, Word raw)
+{
+    int phys = user_translate(pid, logical_addr);
+    if (phys == -1)
+        return -1;
+    return bus_write(phys, raw, 0);
+}
+
+// Lee una palabra del proceso como entero. Retorna 0 si éxito
+static int user_read(int pid, int logical_addr, int *value)
+{
+    Word raw;
+    if (user_read_word(pid, logical_addr, &raw) != 0)
+        return -1;
+    *value = sm_to_int(raw);
+    return 0;
+}
+
+static int user_write(int pid, int logical_addr, int value)
+{
+    return user_write_word(pid, logical_addr, int_to_sm(value));
+}
+
+/**
+ * SYSCALLS 6, 7 y 8: memoria compartida.
+ * Un proceso tiene a lo sumo un segmento (pcb->shm_id); adjuntarlo carga SB/SL,
+ * y la MMU lo muestra a partir de SHM_LOGICAL_BASE.
+ *
+ * Retorna: el resultado de la syscall (id, dirección lógica o 0), -1 si error
+ */
+static int kernel_syscall_shm(int pid, int code, int arg)
+{
+    PCB *pcb = get_pcb(pid);
+    CPU_Context *ctx = process_context(pid);
+    ShmInfo seg;
+
+    if (code == SYS_SHM_CREATE)
+    {
+        if (pcb->shm_id != -1)
+        {
+            // Sólo se puede volver a pedir el mismo segmento
+            shm_get_info(pcb->shm_id, &seg);
+            return seg.key == arg ? pcb->shm_id : -1;
+        }
+
+        int id = shm_open(arg);
+        if (id == -1)
+            return -1;
+        shm_acquire(id);
+        pcb->shm_id = id;
+        write_log(0, "SYSCALL 6: Proceso %d obtiene el segmento %d (clave %d).\n", pid, id, arg);
+        return id;
+    }
+
+    if (code == SYS_SHM_ATTACH)
+    {
+        if (pcb->shm_id != -1 && pcb->shm_id != arg)
+            return -1;
+        if (pcb->shm_id == -1)
+        {
+            if (shm_acquire(arg) != 0)
+                return -1;
+            pcb->shm_id = arg;
+        }
 
-        for (int i = 0; i < MAX_PROCESSES; i++)
+        shm_get_info(arg, &seg);
+        ctx->SB = seg.base;
+        ctx->SL = seg.size;
+        write_log(0, "SYSCALL 7: Proceso %d adjunta el segmento %d en la dir logica %d.\n",
+                  pid, arg, SHM_LOGICAL_BASE);
+        return SHM_LOGICAL_BASE;
+    }
+
+    // SYS_SHM_DETACH
+    if (pcb->shm_id == -1 || pcb->shm_id != arg)
+        return -1;
+    ctx->SB = 0;
+    ctx->SL = 0;
+    shm_release(arg);
+    pcb->shm_id = -1;
+    write_log(0, "SYSCALL 8: Proceso %d suelta el segmento %d.\n", pid, arg);
+    return 0;
+}
+
+// Extremos (PIPE_END_*) que el proceso tiene abiertos del tubo
+static int pipe_ends_of(const PCB *pcb, int pipe_id)
+{
+    int ends = 0;
+    if (pcb->pipe_read_mask & (1u << pipe_id))
+        ends |= PIPE_END_READ;
+    if (pcb->pipe_write_mask & (1u << pipe_id))
+        ends |= PIPE_END_WRITE;
+    return ends;
+}
+
+// Despierta a los procesos bloqueados en el tubo: reintentan su syscall al volver a la CPU
+static void wake_pipe_waiters(int pipe_id)
+{
+    for (int i = kernel_first_process(); pipe_waiters > 0 && i != NULL_PID; i = process_hot[i].next_live)
+    {
+        PCBHot *hot = &process_hot[i];
+        if (hot->state == STATE_BLOCKED && hot->wait_reason == WAIT_PIPE && hot->wait_object == pipe_id)
+        {
+            write_log(0, "KERNEL: El tubo %d avanzo. Proceso %d pasa a LISTO.\n", pipe_id, i);
+            hot->wait_reason = WAIT_NONE;
+            pipe_waiters--;
+            enqueue_ready(i);
+        }
+    }
+}
+
+// Cierra los extremos que el proceso tenía del tubo y avisa a quien espere en el otro
+static void kernel_pipe_close(int pid, int pipe_id)
+{
+    PCB *pcb = get_pcb(pid);
+    int ends = pipe_ends_of(pcb, pipe_id);
+    pcb->pipe_read_mask &= ~(1u << pipe_id);
+    pcb->pipe_write_mask &= ~(1u << pipe_id);
+    pipe_close(pipe_id, ends);
+    wake_pipe_waiters(pipe_id);
+}
+
+/**
+ * SYSCALLS 9 a 12: tubos.
+ * La 11 y la 12 reciben la dirección de un bloque {id, buf, len} en la memoria del proceso
+ * y pasan de una vez todas las palabras que se puedan (a lo sumo len).
+ * Si no se puede pasar ninguna (tubo lleno al escribir, vacío al leer) el proceso queda
+ * BLOCKED (WAIT_PIPE) hasta que el tubo avance, y se devuelve SYSCALL_RETRY.
+ * Cada proceso abre el tubo para leer, escribir o ambas cosas (SYS_PIPE_OPEN = clave * 10 + extremos).
+ * Vacío y sin escritores (tras haber tenido alguno): la lectura devuelve 0 (fin).
+ * Sin lectores (tras haber tenido alguno): la escritura devuelve -1.
+ */
+static SyscallStatus kernel_syscall_pipe(int pid, int code, int arg, int *result)
+{
+    PCB *pcb = get_pcb(pid);
+    PipeInfo info;
+    *result = -1;
+
+    if (code == SYS_PIPE_OPEN)
+    {
+        int key = arg / 10;
+        int ends = arg % 10;
+        if (ends < PIPE_END_READ || ends > (PIPE_END_READ | PIPE_END_WRITE))
+        {
+            write_log(1, "SYSCALL 9: Extremos invalidos (%d) en PID %d.\n", ends, pid);
+            return SYSCALL_DONE;
+        }
+
+        for (int i = 0; i < PIPE_MAX; i++)
         {
-            if (process_table[i].pid != -1 && process_table[i].state == STATE_BLOCKED)
+            if (pipe_ends_of(pcb, i) != 0 && pipe_get_info(i, &info) == 0 && info.key == key)
             {
-                if (process_table[i].wake_time > 0 && system_ticks >= process_table[i].wake_time)
+                ends &= ~pipe_ends_of(pcb, i); // Ya lo tenía abierto: sólo se suman extremos nuevos
+                if (ends == 0)
                 {
-                    write_log(0, "KERNEL: Proceso %d despertó. Pasa a LISTO.\n", i);
-                    process_table[i].wake_time = 0;
-                    enqueue_ready(i);
+                    *result = i;
+                    return SYSCALL_DONE;
                 }
+                break;
+            }
+        }
+
+        int id = pipe_open(key, ends);
+        if (id != -1)
+        {
+            if (ends & PIPE_END_READ)
+                pcb->pipe_read_mask |= 1u << id;
+            if (ends & PIPE_END_WRITE)
+                pcb->pipe_write_mask |= 1u << id;
+            wake_pipe_waiters(id); // Llegó el otro extremo
+            write_log(0, "SYSCALL 9: Proceso %d abre el tubo %d (clave %d, extremos %d).\n", pid, id, key, ends);
+        }
+        *result = id;
+        return SYSCALL_DONE;
+    }
+
+    if (code == SYS_PIPE_CLOSE)
+    {
+        if (arg < 0 || arg >= PIPE_MAX || pipe_ends_of(pcb, arg) == 0)
+            return SYSCALL_DONE;
+        kernel_pipe_close(pid, arg);
+        write_log(0, "SYSCALL 10: Proceso %d cierra el tubo %d.\n", pid, arg);
+        *result = 0;
+        return SYSCALL_DONE;
+    }
+
+    // SYS_PIPE_WRITE / SYS_PIPE_READ: leer el bloque de parámetros
+    int id, buf, len;
+    if (user_read(pid, arg, &id) != 0 || user_read(pid, arg + 1, &buf) != 0 || user_read(pid, arg + 2, &len) != 0 ||
+        id < 0 || id >= PIPE_MAX || len < 0 ||
+        !(pipe_ends_of(pcb, id) & (code == SYS_PIPE_WRITE ? PIPE_END_WRITE : PIPE_END_READ)))
+    {
+        write_log(1, "SYSCALL %d: Bloque de parametros invalido (dir %d) en PID %d.\n", code, arg, pid);
+        return SYSCALL_DONE;
+    }
+    if (len > PIPE_CAPACITY)
+        len = PIPE_CAPACITY; // En una llamada no puede pasar más que lo que entra en el tubo
+
+    Word words[PIPE_CAPACITY];
+    int moved;
+    pipe_get_info(id, &info);
+
+    if (code == SYS_PIPE_WRITE)
+    {
+        for (int i = 0; i < len; i++)
+        {
+            if (user_read_word(pid, buf + i, &words[i]) != 0)
+                return SYSCALL_DONE;
+        }
+        if (len > 0 && info.had_reader && info.readers == 0)
+        {
+            write_log(1, "SYSCALL 11: Tubo %d sin lector (PID %d).\n", id, pid);
+            return SYSCALL_DONE;
+        }
+        moved = pipe_write(id, words, len);
+    }
+    else
+    {
+        // El buffer se valida entero antes de sacar nada: si no, las palabras se perderían
+        for (int i = 0; i < len; i++)
+        {
+            if (user_translate(pid, buf + i) == -1)
+            {
+                write_log(1, "SYSCALL 12: Buffer invalido (dir %d a %d) en PID %d.\n", buf, buf + len - 1, pid);
+                return SYSCALL_DONE;
+            }
+        }
+        if (len > 0 && info.count == 0 && info.had_writer && info.writers == 0)
+        {
+            *result = 0; // Fin: no queda quien escriba
+            return SYSCALL_DONE;
+        }
+        moved = pipe_read(id, words, len);
+        for (int i = 0; i < moved; i++)
+        {
+            if (user_write_word(pid, buf + i, words[i]) != 0)
+                return SYSCALL_DONE;
+        }
+    }
+
+    if (moved == 0 && len > 0)
+    {
+        write_log(0, "SYSCALL %d: Tubo %d %s. Proceso %d pasa a BLOQUEADO.\n",
+                  code, id, code == SYS_PIPE_WRITE ? "lleno" : "vacio", pid);
+        process_hot[pid].state = STATE_BLOCKED;
+        process_hot[pid].wait_reason = WAIT_PIPE;
+        process_hot[pid].wait_object = id;
+        pipe_waiters++;
+        return SYSCALL_RETRY;
+    }
+
+    if (moved > 0)
+        wake_pipe_waiters(id);
+    *result = moved;
+    return SYSCALL_DONE;
+}
+
+// Saca a un proceso de la cola de espera de su dirección (al terminarlo mientras espera)
+static void futex_unlink(int pid)
+{
+    int *link = &futex_head[process_hot[pid].wait_object];
+    while (*link != NULL_PID && *link != pid)
+        link = &process_hot[*link].next_waiter;
+    if (*link == pid)
+    {
+        *link = process_hot[pid].next_waiter;
+        futex_waiters--;
+    }
+    process_hot[pid].next_waiter = NULL_PID;
+}
+
+/**
+ * Despierta hasta max procesos (max <= 0: todos) de la cola de la dirección física phys,
+ * en el orden en que se durmieron.
+ *
+ * Retorna: cantidad de procesos despertados
+ */
+static int futex_wake(int phys, int max)
+{
+    int woken = 0;
+    while (futex_head[phys] != NULL_PID && (max <= 0 || woken < max))
+    {
+        int pid = futex_head[phys];
+        futex_head[phys] = process_hot[pid].next_waiter;
+        process_hot[pid].next_waiter = NULL_PID;
+        process_hot[pid].wait_reason = WAIT_NONE;
+        futex_waiters--;
+        enqueue_ready(pid);
+        woken++;
+    }
+    if (woken > 0)
+        write_log(0, "KERNEL: %d proceso(s) despiertan por la dir %d. Pasan a LISTO.\n", woken, phys);
+    return woken;
+}
+
+// Despierta a quienes esperan las direcciones de las transferencias que terminó el DMA.
+// Se retiran todas las de la cola: si llegan dos antes de revisar no se pierde ninguna
+static int futex_check_dma()
+{
+    int addresses[DMA_DONE_QUEUE];
+    int n, woken = 0;
+    do
+    {
+        n = dma_take_completed(addresses, DMA_DONE_QUEUE);
+        if (n == DMA_DONE_OVERFLOW)
+        {
+            // Se perdieron direcciones: se despierta a todos, cada uno vuelve a mirar su palabra
+            for (int phys = 0; futex_waiters > 0 && phys < MEM_SIZE; phys++)
+                woken += futex_wake(phys, 0);
+            break;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if (futex_waiters > 0 && addresses[i] >= 0 && addresses[i] < MEM_SIZE)
+                woken += futex_wake(addresses[i], 0);
+        }
+    } while (n == DMA_DONE_QUEUE);
+    return woken;
+}
+
+/**
+ * SYSCALLS 13 y 14: esperar / despertar sobre una palabra de memoria (en vez de un bucle de espera).
+ * El bloque de parámetros es {addr, valor} para la 13 y {addr, n} para la 14; addr es lógica
+ * (puede estar en el segmento compartido) y las colas se arman por dirección física,
+ * así dos procesos que comparten la palabra comparten la cola.
+ */
+static SyscallStatus kernel_syscall_futex(int pid, int code, int arg, int *result)
+{
+    int addr, value;
+    *result = -1;
+
+    if (user_read(pid, arg, &addr) != 0 || user_read(pid, arg + 1, &value) != 0)
+    {
+        write_log(1, "SYSCALL %d: Bloque de parametros invalido (dir %d) en PID %d.\n", code, arg, pid);
+        return SYSCALL_DONE;
+    }
+    int phys = user_translate(pid, addr);
+    if (phys == -1)
+    {
+        write_log(1, "SYSCALL %d: Direccion %d fuera del proceso %d.\n", code, addr, pid);
+        return SYSCALL_DONE;
+    }
+
+    if (code == SYS_FUTEX_WAKE)
+    {
+        *result = futex_wake(phys, value);
+        return SYSCALL_DONE;
+    }
+
+    // SYS_FUTEX_WAIT: sólo se duerme si la palabra sigue valiendo lo esperado
+    int current;
+    if (user_read(pid, addr, &current) != 0 || current != value)
+        return SYSCALL_DONE;
+
+    // Al final de la cola de esa dirección
+    int *link = &futex_head[phys];
+    while (*link != NULL_PID)
+        link = &process_hot[*link].next_waiter;
+    *link = pid;
+
+    write_log(0, "SYSCALL 13: Proceso %d espera en la dir %d (valor %d). Pasa a BLOQUEADO.\n", pid, phys, value);
+    process_hot[pid].state = STATE_BLOCKED;
+    process_hot[pid].wait_reason = WAIT_FUTEX;
+    process_hot[pid].wait_object = phys;
+    process_hot[pid].next_waiter = NULL_PID;
+    futex_waiters++;
+    *result = 0; // Lo que verá al despertar
+    return SYSCALL_BLOCKED;
+}
+
+/**
+ * Atiende una llamada al sistema del proceso (código y parámetro ya extraídos).
+ * No planifica: si el resultado no es SYSCALL_DONE, quien llama debe invocar schedule().
+ * El valor que devuelve la llamada (si tiene) queda en *result.
+ */
+static SyscallStatus kernel_do_syscall(int pid, int code, int arg, int *result)
+{
+    *result = 0;
+
+    switch (code)
+    {
+    case SYS_EXIT:
+        write_log(0, "SYSCALL 1: Proceso %d termina con estado %d.\n", pid, arg);
+        kernel_terminate_process(pid);
+        return SYSCALL_EXITED;
+
+    case SYS_PRINT:
+        console_output_value(pid, arg);
+        write_log(0, "SYSCALL 2: Proceso %d imprime %d.\n", pid, arg);
+        return SYSCALL_DONE;
+
+    case SYS_READ:
+        return kernel_syscall_read(pid, result);
+
+    case SYS_SLEEP:
+        if (arg <= 0)
+            return SYSCALL_DONE;
+        write_log(0, "SYSCALL 4: Proceso %d duerme %d tics.\n", pid, arg);
+        process_hot[pid].state = STATE_BLOCKED;
+        process_hot[pid].wake_time = system_ticks + arg;
+        process_hot[pid].wait_reason = WAIT_SLEEP;
+        sleeping_count++;
+        return SYSCALL_BLOCKED;
+
+    case SYS_SHM_CREATE:
+    case SYS_SHM_ATTACH:
+    case SYS_SHM_DETACH:
+        *result = kernel_syscall_shm(pid, code, arg);
+        return SYSCALL_DONE;
+
+    case SYS_PIPE_OPEN:
+    case SYS_PIPE_CLOSE:
+    case SYS_PIPE_WRITE:
+    case SYS_PIPE_READ:
+        return kernel_syscall_pipe(pid, code, arg, result);
+
+    case SYS_FUTEX_WAIT:
+    case SYS_FUTEX_WAKE:
+        return kernel_syscall_futex(pid, code, arg, result);
+
+    default:
+        *result = -1;
+        return SYSCALL_DONE;
+    }
+}
+
+/**
+ * SYSCALL 5: atiende de una vez las solicitudes pendientes del anillo que empieza en ring_addr
+ * (formato en kernel.h). Cada resultado queda en la casilla de resultados de su solicitud.
+ *
+ * Si una solicitud bloquea al proceso (dormir, leer sin entrada) se devuelve SYSCALL_RETRY:
+ * la cabeza del anillo ya indica dónde seguir, así que al despertar el mismo SVC continúa.
+ * Al vaciar el anillo *result es 0 (-1 si el anillo es inválido).
+ */
+static SyscallStatus kernel_syscall_ring(int pid, int ring_addr, int *result)
+{
+    int n, tail, head, last;
+    *result = -1;
+
+    if (user_read(pid, ring_addr, &n) != 0 || user_read(pid, ring_addr + 1, &tail) != 0 ||
+        user_read(pid, ring_addr + 2, &head) != 0)
+    {
+        write_log(1, "SYSCALL 5: Anillo fuera de la particion (dir %d) en PID %d.\n", ring_addr, pid);
+        return SYSCALL_DONE;
+    }
+
+    int results = ring_addr + RING_HDR_WORDS + 2 * n;
+    if (n < 1 || n > SYSCALL_RING_MAX || head < 0 || tail - head < 0 || tail - head > n ||
+        user_read(pid, results + n - 1, &last) != 0)
+    {
+        write_log(1, "SYSCALL 5: Anillo invalido en PID %d (N=%d, cola=%d, cabeza=%d).\n", pid, n, tail, head);
+        return SYSCALL_DONE;
+    }
+
+    int served = 0;
+    while (head != tail)
+    {
+        int slot = head % n;
+        int code, arg, value;
+        user_read(pid, ring_addr + RING_HDR_WORDS + 2 * slot, &code);
+        user_read(pid, ring_addr + RING_HDR_WORDS + 2 * slot + 1, &arg);
+
+        SyscallStatus status;
+        if (code == SYS_RING)
+        {
+            value = -1; // Un anillo dentro del anillo no tiene sentido
+            status = SYSCALL_DONE;
+        }
+        else
+        {
+            status = kernel_do_syscall(pid, code, arg, &value);
+        }
+
+        if (status == SYSCALL_EXITED)
+            return status; // La partición ya no es del proceso: no se escribe nada más
+
+        if (status != SYSCALL_RETRY)
+        {
+            user_write(pid, results + slot, value);
+            head++;
+            served++;
+        }
+        user_write(pid, ring_addr + 2, head);
+
+        if (status != SYSCALL_DONE)
+        {
+            write_log(0, "SYSCALL 5: PID %d se bloquea en la solicitud %d del anillo.\n", pid, head);
+            return SYSCALL_RETRY;
+        }
+    }
+
+    write_log(0, "SYSCALL 5: PID %d, %d solicitud(es) atendidas con un solo SVC.\n", pid, served);
+    *result = 0;
+    return SYSCALL_DONE;
+}
+
+/**
+ * Lee el tope de la pila del proceso sin sacarlo (el anillo lo deja hasta vaciarse).
+ * La pila del usuario va de SP hasta RL (exclusivo): fuera de eso no hay nada apilado.
+ *
+ * Retorna: 0 si éxito, -1 si la pila está vacía o SP quedó fuera de la partición
+ */
+static int kernel_peek_stack(int pid, int *value)
+{
+    CPU_Context *ctx = process_context(pid);
+    if (ctx->SP < ctx->RB || ctx->SP >= ctx->RL)
+    {
+        write_log(1, "KERNEL ERROR: SVC con la pila vacia o fuera de la particion (SP=%d) en PID %d.\n",
+                  ctx->SP, pid);
+        return -1;
+    }
+    return bus_read(ctx->SP, value, 0);
+}
+
+void kernel_handle_interrupt(int interrupt_code)
+{
+    // Con la CPU libre sólo importan el reloj y el DMA: puede haber alguien a quien despertar
+    if (current_pid == NULL_PID && interrupt_code != INT_CLOCK && interrupt_code != INT_IO_END)
+        return;
+
+    if (interrupt_code == INT_CLOCK)
+    {
+        system_ticks++;
+        console_output_tick(system_ticks);
+        futex_check_dma(); // Por si se perdió INT_IO_END (una sola interrupción pendiente a la vez)
+
+        // Sólo se recorren los datos calientes, y sólo si alguien duerme o espera una entrada lista.
+        // De los que esperan entrada se despierta uno por tic: reintenta la syscall 3 al volver a la CPU
+        int wake_input = input_waiters > 0 && console_input_ready();
+        for (int i = kernel_first_process(); (sleeping_count > 0 || wake_input) && i != NULL_PID;
+             i = process_hot[i].next_live)
+        {
+            if (process_hot[i].state != STATE_BLOCKED)
+                continue;
+
+            if (process_hot[i].wait_reason == WAIT_SLEEP && system_ticks >= process_hot[i].wake_time)
+            {
+                write_log(0, "KERNEL: Proceso %d despertó. Pasa a LISTO.\n", i);
+                process_hot[i].wake_time = 0;
+                process_hot[i].wait_reason = WAIT_NONE;
+                sleeping_count--;
+                enqueue_ready(i);
+            }
+            else if (process_hot[i].wait_reason == WAIT_INPUT && wake_input)
+            {
+                write_log(0, "KERNEL: Hay entrada para el proceso %d. Pasa a LISTO.\n", i);
+                process_hot[i].wait_reason = WAIT_NONE;
+                input_waiters--;
+                wake_input = 0;
+                enqueue_ready(i);
             }
         }
 
         if (current_pid != NULL_PID)
         {
-            process_table[current_pid].quantum_counter++;
+            process_hot[current_pid].quantum_counter++;
 
-            if (process_table[current_pid].quantum_counter >= QUANTUM_TICKS)
+            if (process_hot[current_pid].quantum_counter >= QUANTUM_TICKS)
             {
                 write_log(0, "KERNEL: PID %d agotó su quantum.\n", current_pid);
                 schedule();
@@ -372,6 +1707,23 @@ void kernel_handle_interrupt(int interrupt_code)
             {
                 schedule();
             }
+            else if (pipe_waiters + futex_waiters > 0 && pipe_waiters + futex_waiters == active_count &&
+                     !dma_is_busy() && futex_check_dma() == 0)
+            {
+                // El DMA está libre y su cola ya se retiró (anota la dirección antes de soltar BUSY):
+                // ninguna transferencia pendiente va a despertar a nadie
+                // Todos esperan un tubo o una palabra que ningún otro (ni el DMA) va a tocar: nunca despertarían
+                write_log(1, "KERNEL: Bloqueo mutuo: %d proceso(s) esperan tubos o direcciones. Se terminan.\n",
+                          pipe_waiters + futex_waiters);
+                for (int i = kernel_first_process(); i != NULL_PID;)
+                {
+                    int next = process_hot[i].next_live;
+                    if (process_hot[i].state == STATE_BLOCKED &&
+                        (process_hot[i].wait_reason == WAIT_PIPE || process_hot[i].wait_reason == WAIT_FUTEX))
+                        kernel_terminate_process(i);
+                    i = next;
+                }
+            }
         }
     }
     else if (interrupt_code == INT_INV_ADDR || interrupt_code == INT_UNDERFLOW ||
@@ -380,129 +1732,85 @@ void kernel_handle_interrupt(int interrupt_code)
         write_log(1, "KERNEL: Error fatal (Cod %d) en PID %d. Terminando.\n",
                   interrupt_code, current_pid);
 
-        process_table[current_pid].state = STATE_TERMINATED;
-
-        if (process_table[current_pid].partition_id != -1)
-        {
-            partitions_bitmap[process_table[current_pid].partition_id] = false;
-        }
-
+        kernel_terminate_process(current_pid);
         schedule();
     }
     else if (interrupt_code == INT_IO_END)
     {
+        futex_check_dma();
+
         int dma_state = dma_get_state();
-        if (dma_state != 0)
+        if (dma_state != 0 && current_pid != NULL_PID)
         {
             write_log(1, "KERNEL: Error DMA en PID %d. Terminando.\n", current_pid);
-            process_table[current_pid].state = STATE_TERMINATED;
-            if (process_table[current_pid].partition_id != -1)
-            {
-                partitions_bitmap[process_table[current_pid].partition_id] = false;
-            }
+            kernel_terminate_process(current_pid);
             schedule();
         }
     }
     else if (interrupt_code == INT_SYSCALL)
     {
-        int syscall_code = sm_to_int(process_table[current_pid].context.AC);
+        int pid = current_pid;
+        CPU_Context *ctx = process_context(pid); // Los registros de la CPU: el proceso está corriendo
+        int regs = get_pcb(pid)->abi == ABI_REGISTERS;
+        int syscall_code = sm_to_int(ctx->AC);
         int param_raw = 0;
-        int param_real = 0;
+        int result = 0;
+        SyscallStatus status;
 
-        switch (syscall_code)
+        if (syscall_code < SYS_EXIT || syscall_code > SYS_LAST)
         {
-        case 1:
-            if (kernel_pop_stack(current_pid, &param_raw) == 0)
-            {
-                param_real = sm_to_int(param_raw);
-                write_log(0, "SYSCALL 1: Proceso %d termina con estado %d.\n", current_pid, param_real);
-                process_table[current_pid].state = STATE_TERMINATED;
-                if (process_table[current_pid].partition_id != -1)
-                {
-                    partitions_bitmap[process_table[current_pid].partition_id] = false;
-                }
-                schedule();
-            }
-            break;
+            write_log(1, "KERNEL ERROR: Syscall desconocida (%d) del PID %d. Violación de seguridad.\n", syscall_code, pid);
+            // Parche: Asesinar al proceso rebelde
+            kernel_terminate_process(pid);
+            schedule(); // Cambiar de proceso inmediatamente
+            return;
+        }
 
-        case 2:
-            if (kernel_pop_stack(current_pid, &param_raw) == 0)
+        // Con la pila, el parámetro se saca recién cuando la syscall se atendió:
+        // si hay que reintentar el SVC, lo vuelve a encontrar en el mismo lugar
+        int uses_stack = !regs && syscall_code != SYS_READ;
+        if (syscall_code != SYS_READ)
+        {
+            if (regs)
+                param_raw = ctx->RX;
+            else if (kernel_peek_stack(pid, &param_raw) != 0)
             {
-                param_real = sm_to_int(param_raw);
-                printf("\n[PROCESO %d]> %d\n", current_pid, param_real);
-                write_log(0, "SYSCALL 2: Proceso %d imprime %d.\n", current_pid, param_real);
+                // Sin parámetro no hay syscall que atender: igual que una desconocida
+                kernel_terminate_process(pid);
+                schedule();
+                return;
             }
-            break;
-
-        case 3:
-            printf("\n[ENTRADA %d]> Ingrese un entero (o teclee 'memestat' / 'ps'): ", current_pid);
-            char input_str[50];
+        }
 
-            while (1)
-            {
-                if (scanf("%s", input_str) == 1)
-                {
-                    if (strcmp(input_str, "ps") == 0)
-                    {
-                        extern void cmd_ps();
-                        cmd_ps();
-                        printf("\n[ENTRADA %d]> Ingrese un entero: ", current_pid);
-                    }
-                    else if (strcmp(input_str, "memestat") == 0)
-                    {
-                        extern void cmd_memestat();
-                        cmd_memestat();
-                        printf("\n[ENTRADA %d]> Ingrese un entero: ", current_pid);
-                    }
-                    else
-                    {
-                        // Si no es un comando de auditoría, asumimos que es un numero
-                        int input_val = atoi(input_str);
-                        process_table[current_pid].context.AC = int_to_sm(input_val);
-                        write_log(0, "SYSCALL 3: Proceso %d leyó %d.\n", current_pid, input_val);
-                        break; // Salimos del bucle infinito para continuar la ejecución
-                    }
-                }
-            }
-            break;
-        case 4:
-            if (kernel_pop_stack(current_pid, &param_raw) == 0)
-            {
-                param_real = sm_to_int(param_raw);
-                if (param_real > 0)
-                {
-                    write_log(0, "SYSCALL 4: Proceso %d duerme %d tics.\n", current_pid, param_real);
-                    process_table[current_pid].state = STATE_BLOCKED;
-                    process_table[current_pid].wake_time = system_ticks + param_real;
-                    schedule();
-                }
-            }
-            break;
+        if (syscall_code == SYS_RING)
+            status = kernel_syscall_ring(pid, sm_to_int(param_raw), &result);
+        else
+            status = kernel_do_syscall(pid, syscall_code, sm_to_int(param_raw), &result);
 
-        default:
-            write_log(1, "KERNEL ERROR: Syscall desconocida (%d) del PID %d. Violación de seguridad.\n", syscall_code, current_pid);
-            // Parche: Asesinar al proceso rebelde
-            process_table[current_pid].state = STATE_TERMINATED;
-            if (process_table[current_pid].partition_id != -1)
-            {
-                partitions_bitmap[process_table[current_pid].partition_id] = false;
-            }
-            schedule(); // Cambiar de proceso inmediatamente
-            break;
+        if (status == SYSCALL_DONE || status == SYSCALL_BLOCKED)
+        {
+            if (uses_stack)
+                ctx->SP++;
+            // Con la pila, salir, imprimir y dormir dejan AC como estaba
+            if (regs || syscall_code == SYS_READ || syscall_code >= SYS_RING)
+                ctx->AC = int_to_sm(result);
         }
+
+        if (status == SYSCALL_RETRY)
+            ctx->PSW.PC--; // Vuelve a ejecutar el SVC al despertar
+        if (status != SYSCALL_DONE)
+            schedule();
     }
 }
 
 int kernel_pop_stack(int pid, int *value)
 {
-    int sp = process_table[pid].context.SP;
-
-    if (bus_read(sp, value, 0) != 0)
+    if (kernel_peek_stack(pid, value) != 0)
     {
         return -1;
     }
 
-    process_table[pid].context.SP++;
+    process_context(pid)->SP++;
 
     return 0;
 }
\ No newline at end of file
@@ -3,9 +3,11 @@
 
 #include "brain.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 // --- CONSTANTES ---
-#define MAX_PROCESSES 20
+#define PROCESS_TABLE_INITIAL_CAPACITY 32 // La tabla de procesos crece al doble cuando se llena
+#define MAX_PROCESSES 65536                // Tope de PIDs simultáneos
 #define QUANTUM_TICKS 2
 #define NULL_PID -1
 
@@ -13,8 +15,16 @@
 #define NUM_PARTITIONS 5
 #define PARTITION_SIZE 340
 
+// --- CONVENCIÓN DE LAS LLAMADAS AL SISTEMA (.ABI) ---
+// En las dos el código va en AC y el resultado vuelve en AC (las que devuelven algo, como la 3, lo hacen en las dos)
+typedef enum
+{
+    ABI_STACK,    // .ABI pila (por defecto): el parámetro se saca de la pila (PSH antes del SVC)
+    ABI_REGISTERS // .ABI registros: el parámetro va en RX; no se toca la pila
+} SyscallABI;
+
 // --- TABLA DE ARCHIVOS (FILE TABLE) ---
-#define MAX_FILE_TABLE MAX_PROCESSES
+#define FILE_TABLE_INITIAL_CAPACITY 32 // La tabla crece al doble cuando se llena
 
 typedef enum
 {
@@ -35,6 +45,13 @@ typedef struct
     int partition_id; // ID partición RAM (-1 si sólo en disco)
     FileState state;  // Estado: DISK, READY, RUNNING, TERMINATED
     int n_start;      // Índice _start del programa
+
+    // Archivo de origen en la PC real (para detectar cambios entre corridas)
+    uint64_t content_hash;  // FNV-1a 64 del contenido (0 si se desconoce)
+    long long source_mtime; // Fecha de modificación al cargarlo
+    long long source_size;  // Tamaño en bytes al cargarlo
+
+    SyscallABI abi; // Convención de las syscalls (.ABI)
 } FileTableEntry;
 
 // --- ESTADOS DEL PROCESO ---
@@ -47,33 +64,92 @@ typedef enum
     STATE_TERMINATED // Finalizó ejecución
 } ProcessState;
 
+// --- LLAMADAS AL SISTEMA ---
+// SVC con el código en AC; el parámetro (si hay) va en el tope de la pila del usuario o en RX (ver SyscallABI)
+#define SYS_EXIT 1  // Termina el proceso (parámetro: estado)
+#define SYS_PRINT 2 // Imprime el parámetro
+#define SYS_READ 3  // Lee un entero de la consola (resultado en AC)
+#define SYS_SLEEP 4 // Duerme tantos tics como diga el parámetro
+#define SYS_RING 5  // Atiende el anillo de solicitudes cuya dirección es el parámetro
+#define SYS_SHM_CREATE 6 // Crea (o abre) el segmento compartido de clave = parámetro; resultado: id
+#define SYS_SHM_ATTACH 7 // Adjunta el segmento id; resultado: SHM_LOGICAL_BASE
+#define SYS_SHM_DETACH 8 // Suelta el segmento id; resultado: 0
+#define SYS_PIPE_OPEN 9   // Parámetro: clave * 10 + extremos (1 = leer, 2 = escribir, 3 = ambos); crea o abre el tubo. Resultado: id
+#define SYS_PIPE_CLOSE 10 // Cierra los extremos que el proceso tiene del tubo id; resultado: 0
+#define SYS_PIPE_WRITE 11 // Parámetro: dirección de {id, buf, len}; resultado: palabras escritas
+#define SYS_PIPE_READ 12  // Parámetro: dirección de {id, buf, len}; resultado: palabras leídas (0 = fin)
+#define SYS_FUTEX_WAIT 13 // Parámetro: dirección de {addr, valor}; duerme si Mem[addr] == valor. Resultado: 0, o -1 si era distinto
+#define SYS_FUTEX_WAKE 14 // Parámetro: dirección de {addr, n}; despierta hasta n (n <= 0: todos). Resultado: despertados
+#define SYS_LAST SYS_FUTEX_WAKE
+
+// Anillo de solicitudes: muchas llamadas con un solo SVC.
+// Vive en la partición del proceso; desde su dirección lógica R:
+//   R+0              N, cantidad de casillas (1..SYSCALL_RING_MAX)
+//   R+1              cola: número de la próxima solicitud (la avanza el proceso)
+//   R+2              cabeza: número de la próxima a atender (la avanza el kernel)
+//   R+3+2i, R+4+2i   código y parámetro de la casilla i (cualquier código salvo 5)
+//   R+3+2N+i         resultado de la casilla i (-1 si el código no es válido)
+// La solicitud número s ocupa la casilla s % N. Al vaciar el anillo AC = 0 (-1 si el anillo es inválido).
+#define SYSCALL_RING_MAX 64
+#define RING_HDR_WORDS 3
+
+// --- MOTIVO DE BLOQUEO ---
+typedef enum
+{
+    WAIT_NONE,  // No está bloqueado
+    WAIT_SLEEP, // Syscall 4: despierta en wake_time
+    WAIT_INPUT, // Syscall 3: despierta cuando la consola tiene una línea (y reintenta la syscall)
+    WAIT_PIPE,  // Syscalls 11/12: despierta cuando el tubo wait_object avanza (y reintenta la syscall)
+    WAIT_FUTEX  // Syscall 13: despierta con la 14 o cuando el DMA escribe la dirección física wait_object
+} WaitReason;
+
+// --- DATOS CALIENTES DEL PROCESO ---
+// Lo que el planificador toca en cada tic va en un arreglo aparte (process_hot),
+// compacto, así recorrer procesos no arrastra nombres ni contextos por la caché
+typedef struct
+{
+    ProcessState state;  // Estado actual
+    int quantum_counter; // Ticks consumidos en el turno actual
+    int wake_time;       // Tick en el que debe despertar
+    WaitReason wait_reason; // Por qué está BLOCKED
+    int wait_object;        // Qué espera (WAIT_PIPE: id del tubo, WAIT_FUTEX: dirección física)
+    int next_waiter;        // Siguiente en la cola de espera de la misma dirección (WAIT_FUTEX)
+
+    // Lista de procesos vivos (no TERMINATED), para no recorrer la tabla entera
+    int next_live;
+    int prev_live;
+} PCBHot;
+
 // --- BLOQUE DE CONTROL DE PROCESO (PCB) ---
+// Datos fríos: se leen al crear, despachar o cargar el proceso
 typedef struct
 {
-    int pid;            // ID del proceso (0 a 19)
-    char name[50];      // Nombre del programa
-    ProcessState state; // Estado actual
+    int pid;       // ID del proceso (índice en process_table)
+    char name[50]; // Nombre del programa
 
     CPU_Context context; // Registros (PC, AC, SP, etc.)
 
     // Gestión de Memoria
     int partition_id; // Qué partición ocupa (-1 si ninguna)
 
-    // Planificación
-    int quantum_counter; // Ticks consumidos en el turno actual
-    int wake_time;       // Tick en el que debe despertar
-
     // Gestión de Archivo (Simulación disco)
     int disk_track;
     int disk_sector;
     int disk_cylinder;
     int prog_size; // Tamaño en palabras
 
+    int input_prompted; // Ya se mostró el aviso de la syscall 3 (evita repetirlo al reintentar)
+    SyscallABI abi;     // De dónde saca el parámetro el SVC (copiado de la tabla de archivos)
+    int shm_id;         // Segmento compartido que tiene (creado o adjuntado), -1 si ninguno
+    unsigned pipe_read_mask;  // Tubos abiertos para leer (bit i = tubo i)
+    unsigned pipe_write_mask; // Tubos abiertos para escribir
+
 } PCB;
 
 // --- VARIABLES GLOBALES DEL KERNEL ---
-extern PCB process_table[MAX_PROCESSES];
-extern FileTableEntry file_table[MAX_FILE_TABLE];
+extern PCB *process_table;   // Crece a demanda, indexada por PID (datos fríos)
+extern PCBHot *process_hot;  // Misma capacidad e índice que process_table (datos calientes)
+extern FileTableEntry *file_table;
 extern int file_table_count;
 extern int current_pid;
 extern int system_ticks;
@@ -87,12 +163,24 @@ void kernel_init_structures();
 // Gestión de Procesos
 int create_process(const char *name, int track, int cylinder, int sector, int size);
 PCB *get_pcb(int pid);
+PCBHot *get_pcb_hot(int pid);
+CPU_Context *process_context(int pid); // Registros del proceso (los de la CPU si está corriendo)
+void kernel_terminate_process(int pid); // Pasa a TERMINATED, libera partición y PID
+int kernel_first_process();             // Primer proceso vivo (no TERMINATED), o NULL_PID
+int kernel_next_process(int pid);       // Siguiente proceso vivo, o NULL_PID
+int kernel_active_count();              // Procesos en RAM (READY, RUNNING o BLOCKED)
+int kernel_terminated_count();          // Procesos terminados desde el último reinicio
 
 // Gestión de Tabla de Archivos
 int file_table_search_by_name(const char *program_name); // Busca por nombre, retorna índice o -1
 int file_table_find_by_pid(int pid);                     // Busca por PID, retorna índice o -1
+int file_table_find_by_hash(uint64_t hash, int size);    // Busca una imagen igual ya en disco, índice o -1
 FileTableEntry *get_file_table_entry(int index);         // Obtiene puntero a entrada válida
+void file_table_set_pid(int index, int pid);             // Asocia un PID a la entrada (-1 la libera)
 int file_table_add_entry(const char *program_name, int track, int cylinder, int sector, int size, int n_start);
+int file_table_remove(int index); // Elimina la entrada y libera sus sectores, 0 si éxito
+int file_table_save();    // Guarda la tabla en el disco (metadatos + extensión), 0 si éxito
+int file_table_restore(); // Recupera la tabla desde el disco, retorna cantidad de entradas
 
 // Utilidades
 const char *state_to_string(ProcessState s);
@@ -1,127 +1,417 @@
 #include "load.h"
 #include "disk.h"
+#include "cache.h"
+#include "diskmap.h"
 #include "kernel.h"
 #include "bus.h"
 #include "log.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+// Archivo fuente mapeado en memoria (solo lectura, sin copiarlo a un buffer)
+typedef struct
+{
+    const char *data; // Contenido del archivo tal cual esta en la PC real
+    size_t size;
+    long long mtime;             // Fecha de modificacion del archivo
+    const int32_t *binary_words; // Palabras del ejecutable binario (NULL si es texto)
+    int word_count;     // Palabras (instrucciones/datos) encontradas
+    int n_start;        // Indice _start en base 0
+    int declared_words; // .NumeroPalabras (-1 si no se declaro)
+    char prog_name[50]; // .NombreProg
+    SyscallABI abi;     // .ABI (pila por defecto)
+} ProgramSource;
+
+// Tipos de linea que reconoce el escaner
+typedef enum
+{
+    LINE_END,       // No quedan lineas
+    LINE_WORD,      // Instruccion o dato numerico
+    LINE_START,     // _start N
+    LINE_NUM_WORDS, // .NumeroPalabras N
+    LINE_NAME,      // .NombreProg nombre
+    LINE_ABI        // .ABI pila|registros
+} LineKind;
+
+static int is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
 
-#define MAX_WORDS_BUFFER 1000
+static int is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
 
-/**
- * Lee un archivo .txt y lo almacena en un buffer
- *
- * Retorna:
- *   - Numero de palabras leidas (>= 0) si exito
- *   - -1 si error
- */
-static int read_program_file(const char *filename, Word *words_buffer,
-                             int *out_n_start, char *out_prog_name)
+static const char *skip_blanks(const char *p, const char *end)
 {
-    FILE *file = fopen(filename, "r");
-    if (!file)
+    while (p < end && is_blank(*p))
+        p++;
+    return p;
+}
+
+static const char *token_end(const char *p, const char *end)
+{
+    while (p < end && !is_blank(*p))
+        p++;
+    return p;
+}
+
+// Compara el token [p, tok_end) con una palabra clave
+static int token_is(const char *p, const char *tok_end, const char *keyword)
+{
+    size_t len = strlen(keyword);
+    return (size_t)(tok_end - p) == len && memcmp(p, keyword, len) == 0;
+}
+
+// Convierte un entero decimal con signo opcional. Retorna 1 si habia al menos un digito
+static int scan_int(const char *p, const char *end, int *out)
+{
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+'))
     {
-        write_log(1, "LOADER: No se pudo abrir el archivo: %s\n", filename);
-        return -1;
+        negative = (*p == '-');
+        p++;
     }
+    if (p >= end || !is_digit(*p))
+        return 0;
 
-    char line[256];
-    char aux_word[100];
-    int word_count = 0;
-    int n_start = 0;
-    int declared_words = -1;
-    char prog_name[50] = {0};
+    long long value = 0;
+    while (p < end && is_digit(*p))
+    {
+        value = value * 10 + (*p - '0');
+        if (value > 2147483647LL)
+            value = 2147483647LL;
+        p++;
+    }
+    *out = (int)(negative ? -value : value);
+    return 1;
+}
 
-    write_log(1, "LOADER: Leyendo archivo %s desde PC real...\n", filename);
+/**
+ * Escaner de lineas sobre el archivo mapeado.
+ * Avanza *pos hasta la siguiente linea util y la clasifica.
+ * En *value deja el numero de la linea (palabra, _start o .NumeroPalabras)
+ * y en arg/arg_len el argumento de .NombreProg o .ABI (apunta dentro del mapeo).
+ */
+static LineKind source_next_line(const ProgramSource *src, size_t *pos, int *value,
+                                 const char **arg, size_t *arg_len)
+{
+    const char *end = src->data + src->size;
 
-    while (fgets(line, sizeof(line), file))
+    while (*pos < src->size)
     {
-        // 1. Leer primera palabra de la linea
-        if (sscanf(line, "%s", aux_word) != 1)
+        const char *line = src->data + *pos;
+        const char *eol = memchr(line, '\n', end - line);
+        if (eol == NULL)
+            eol = end;
+        *pos = (size_t)(eol - src->data) + 1;
+
+        // 1. Primera palabra de la linea
+        const char *p = skip_blanks(line, eol);
+        if (p == eol)
             continue;
+        const char *tok = token_end(p, eol);
 
         // 2. Ignorar comentarios
-        if (strncmp(aux_word, "//", 2) == 0)
+        if (tok - p >= 2 && p[0] == '/' && p[1] == '/')
             continue;
 
-        // 3. PROCESAR DIRECTIVAS
-        if (strcmp(aux_word, "_start") == 0)
+        // 3. Directivas
+        if (token_is(p, tok, "_start"))
         {
-            int lineaStart;
-            sscanf(line, "%*s %d", &lineaStart);
-
-            // Ajuste de Base 1 a Base 0
-            if (lineaStart > 0)
-                n_start = lineaStart - 1;
-            else
-                n_start = 0;
-
-            write_log(0, "LOADER: Directiva _start %d -> n_start = %d\n", lineaStart, n_start);
-            continue;
+            if (!scan_int(skip_blanks(tok, eol), eol, value))
+                *value = 0;
+            return LINE_START;
         }
-
-        if (strcmp(aux_word, ".NumeroPalabras") == 0)
+        if (token_is(p, tok, ".NumeroPalabras"))
         {
-            sscanf(line, "%*s %d", &declared_words);
-            write_log(0, "LOADER: Palabras declaradas: %d\n", declared_words);
-            continue;
+            if (!scan_int(skip_blanks(tok, eol), eol, value))
+                *value = -1;
+            return LINE_NUM_WORDS;
+        }
+        if (token_is(p, tok, ".NombreProg"))
+        {
+            const char *name = skip_blanks(tok, eol);
+            *arg = name;
+            *arg_len = (size_t)(token_end(name, eol) - name);
+            return LINE_NAME;
+        }
+        if (token_is(p, tok, ".ABI"))
+        {
+            const char *abi = skip_blanks(tok, eol);
+            *arg = abi;
+            *arg_len = (size_t)(token_end(abi, eol) - abi);
+            return LINE_ABI;
         }
 
-        if (strcmp(aux_word, ".NombreProg") == 0)
+        // 4. Instrucciones / datos: el numero al inicio de la linea
+        if (is_digit(p[0]) || (p[0] == '-' && p + 1 < tok && is_digit(p[1])))
         {
-            sscanf(line, "%*s %s", prog_name);
-            write_log(0, "LOADER: Nombre del programa: %s\n", prog_name);
-            continue;
+            scan_int(p, tok, value);
+            return LINE_WORD;
         }
+    }
+    return LINE_END;
+}
+
+/**
+ * Mapea el archivo fuente en memoria
+ *
+ * Retorna: 0 si exito, -1 si error
+ */
+static int source_open(const char *filename, ProgramSource *src)
+{
+    memset(src, 0, sizeof(*src));
+    src->declared_words = -1;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        write_log(1, "LOADER: No se pudo abrir el archivo: %s\n", filename);
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        write_log(1, "LOADER: No se pudo consultar el archivo: %s\n", filename);
+        close(fd);
+        return -1;
+    }
+
+    src->size = (size_t)st.st_size;
+    src->mtime = (long long)st.st_mtime;
+    if (src->size == 0)
+    {
+        src->data = "";
+        close(fd);
+        return 0;
+    }
+
+    void *map = mmap(NULL, src->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // El mapeo sigue valido sin el descriptor
+    if (map == MAP_FAILED)
+    {
+        write_log(1, "LOADER: No se pudo mapear el archivo: %s\n", filename);
+        return -1;
+    }
+    madvise(map, src->size, MADV_SEQUENTIAL);
+    src->data = (const char *)map;
+    return 0;
+}
+
+static void source_close(ProgramSource *src)
+{
+    if (src->size > 0 && src->data != NULL)
+        munmap((void *)src->data, src->size);
+    src->data = NULL;
+    src->size = 0;
+}
+
+// Suma de verificacion FNV-1a de las palabras del ejecutable
+static uint32_t exe_checksum(const int32_t *words, int count)
+{
+    uint32_t hash = 2166136261u;
+    const unsigned char *bytes = (const unsigned char *)words;
+    for (size_t i = 0; i < (size_t)count * sizeof(int32_t); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Hash FNV-1a de 64 bits sobre los bytes del archivo fuente (clave de la cache de programas)
+static uint64_t source_hash(const ProgramSource *src)
+{
+    uint64_t hash = 14695981039346656037ull;
+    const unsigned char *bytes = (const unsigned char *)src->data;
+    for (size_t i = 0; i < src->size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Indica si el archivo mapeado empieza con la cabecera del formato binario
+static int source_is_binary(const ProgramSource *src)
+{
+    return src->size >= sizeof(ExeHeader) && ((const ExeHeader *)src->data)->magic == EXE_MAGIC;
+}
+
+/**
+ * Valida la cabecera del ejecutable binario y deja las palabras apuntando al mapeo
+ *
+ * Retorna: numero de palabras si exito, -1 si el ejecutable es invalido
+ */
+static int parse_program_binary(ProgramSource *src, const char *filename)
+{
+    const ExeHeader *hdr = (const ExeHeader *)src->data;
+
+    if (hdr->version != EXE_VERSION)
+    {
+        write_log(1, "LOADER ERROR: %s: version de ejecutable %d no soportada.\n", filename, hdr->version);
+        return -1;
+    }
+    if (hdr->word_count < 0 ||
+        src->size != sizeof(ExeHeader) + (size_t)hdr->word_count * sizeof(int32_t))
+    {
+        write_log(1, "LOADER ERROR: %s: tamano inconsistente con la cabecera.\n", filename);
+        return -1;
+    }
+
+    // El mapeo empieza alineado a pagina y la cabecera mide un multiplo de 4
+    src->binary_words = (const int32_t *)(src->data + sizeof(ExeHeader));
+    if (exe_checksum(src->binary_words, hdr->word_count) != hdr->checksum)
+    {
+        write_log(1, "LOADER ERROR: %s: suma de verificacion invalida.\n", filename);
+        src->binary_words = NULL;
+        return -1;
+    }
+    if (hdr->n_start < 0 || hdr->n_start >= hdr->word_count)
+    {
+        write_log(1, "LOADER ERROR: %s: n_start %d fuera del programa (%d palabras).\n",
+                  filename, hdr->n_start, hdr->word_count);
+        src->binary_words = NULL;
+        return -1;
+    }
+
+    src->word_count = hdr->word_count;
+    src->declared_words = hdr->word_count;
+    src->n_start = hdr->n_start;
+    src->abi = (hdr->flags & EXE_FLAG_REG_ABI) ? ABI_REGISTERS : ABI_STACK;
+    memcpy(src->prog_name, hdr->name, sizeof(hdr->name));
+    src->prog_name[sizeof(hdr->name) - 1] = '\0';
+
+    write_log(0, "LOADER: Ejecutable binario '%s' valido. %d palabras, n_start = %d\n",
+              src->prog_name, src->word_count, src->n_start);
+    return src->word_count;
+}
+
+/**
+ * Devuelve la siguiente palabra del programa, venga de texto o del binario.
+ * *pos es el cursor (byte en el texto o indice en el binario), empieza en 0.
+ *
+ * Retorna: 1 si hay palabra, 0 si no quedan
+ */
+static int source_next_word(const ProgramSource *src, size_t *pos, int *word)
+{
+    if (src->binary_words != NULL)
+    {
+        if (*pos >= (size_t)src->word_count)
+            return 0;
+        *word = src->binary_words[(*pos)++];
+        return 1;
+    }
+
+    const char *arg = NULL;
+    size_t arg_len = 0;
+    LineKind kind;
+    while ((kind = source_next_line(src, pos, word, &arg, &arg_len)) != LINE_END)
+    {
+        if (kind == LINE_WORD)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * Primera pasada sobre el archivo mapeado: lee las directivas y cuenta las palabras.
+ * No guarda las palabras; se escriben al disco en la segunda pasada.
+ *
+ * Retorna:
+ *   - Numero de palabras (>= 0) si exito
+ *   - -1 si error
+ */
+static int parse_program_source(ProgramSource *src, const char *filename)
+{
+    size_t pos = 0;
+    int value = 0;
+    const char *arg = NULL;
+    size_t arg_len = 0;
+    LineKind kind;
 
-        // 4. PROCESAR INSTRUCCIONES / DATOS
-        if (isdigit(aux_word[0]) || (aux_word[0] == '-' && isdigit(aux_word[1])))
+    write_log(1, "LOADER: Leyendo archivo %s desde PC real...\n", filename);
+
+    while ((kind = source_next_line(src, &pos, &value, &arg, &arg_len)) != LINE_END)
+    {
+        switch (kind)
         {
-            // Validar que no superemos el buffer
-            if (word_count >= MAX_WORDS_BUFFER)
+        case LINE_START:
+            // Ajuste de Base 1 a Base 0
+            src->n_start = (value > 0) ? value - 1 : 0;
+            write_log(0, "LOADER: Directiva _start %d -> n_start = %d\n", value, src->n_start);
+            break;
+        case LINE_NUM_WORDS:
+            src->declared_words = value;
+            write_log(0, "LOADER: Palabras declaradas: %d\n", value);
+            break;
+        case LINE_NAME:
+            if (arg_len > sizeof(src->prog_name) - 1)
+                arg_len = sizeof(src->prog_name) - 1;
+            memcpy(src->prog_name, arg, arg_len);
+            src->prog_name[arg_len] = '\0';
+            write_log(0, "LOADER: Nombre del programa: %s\n", src->prog_name);
+            break;
+        case LINE_ABI:
+            if (token_is(arg, arg + arg_len, "registros"))
+                src->abi = ABI_REGISTERS;
+            else if (token_is(arg, arg + arg_len, "pila"))
+                src->abi = ABI_STACK;
+            else
             {
-                write_log(1, "LOADER ERROR: Buffer de palabras desbordado (max %d).\n", MAX_WORDS_BUFFER);
-                fclose(file);
+                write_log(1, "LOADER ERROR: .ABI desconocida (use 'pila' o 'registros').\n");
                 return -1;
             }
-
-            Word word;
-            sscanf(line, "%d", &word);
-            words_buffer[word_count] = word;
-            word_count++;
+            write_log(0, "LOADER: Syscalls con el parametro en %s\n", src->abi == ABI_REGISTERS ? "RX" : "la pila");
+            break;
+        case LINE_WORD:
+            src->word_count++;
+            break;
+        default:
+            break;
         }
     }
 
-    fclose(file);
-
     // Validacion estricta de cantidad
-    if (declared_words != -1 && word_count != declared_words)
+    if (src->declared_words != -1 && src->word_count != src->declared_words)
     {
         write_log(1, "LOADER ERROR: Inconsistencia. Declaradas: %d, Leidas: %d.\n",
-                  declared_words, word_count);
+                  src->declared_words, src->word_count);
         return -1;
     }
 
-    *out_n_start = n_start;
-    strncpy(out_prog_name, prog_name, 49);
-    out_prog_name[49] = '\0';
+    // Mismo rango que exige el formato binario: si no, la cache y convertir fallarian despues
+    if (src->n_start >= src->word_count)
+    {
+        write_log(1, "LOADER ERROR: %s: n_start %d fuera del programa (%d palabras).\n",
+                  filename, src->n_start, src->word_count);
+        return -1;
+    }
 
-    write_log(0, "LOADER: Archivo parseado exitosamente. Total: %d palabras.\n", word_count);
-    return word_count;
+    write_log(0, "LOADER: Archivo parseado exitosamente. Total: %d palabras.\n", src->word_count);
+    return src->word_count;
 }
 
 /**
- * Se escribe el programa en el disco
+ * Segunda pasada: escribe las palabras del archivo mapeado directamente en el disco,
+ * una por sector, sin buffer intermedio
  *
  * Retorna: 0 si exito, -1 si error
  */
-static int write_program_to_disk(const Word *words_buffer, int word_count,
+static int write_program_to_disk(const ProgramSource *src,
                                  int track, int cylinder, int sector_start)
 {
     write_log(1, "LOADER: Escribiendo %d palabras en disco (Track=%d, Cyl=%d, Sec=%d)...\n",
-              word_count, track, cylinder, sector_start);
+              src->word_count, track, cylinder, sector_start);
 
     // Buffer temporal para un sector (9 bytes maximo segun SECTOR_BYTES)
     char sector_buffer[SECTOR_BYTES];
@@ -131,52 +421,62 @@ static int write_program_to_disk(const Word *words_buffer, int word_count,
     int current_sector = sector_start;
     int words_written = 0;
 
-    // Escribir cada palabra
-    for (int i = 0; i < word_count; i++)
+    size_t pos = 0;
+    int word = 0;
+
+    // Escribir cada palabra (queda en el buffer cache hasta sincronizar)
+    while (source_next_word(src, &pos, &word))
     {
-        // Convertir palabra a string (maximo 8 digitos segun WORD_DIGITS)
-        char word_str[20];
-        snprintf(word_str, sizeof(word_str), "%08d", words_buffer[i]);
+        if (words_written > 0)
+        {
+            // Avanzar al siguiente sector
+            current_sector++;
+
+            // Si se alcanzo el limite de sectores en un cilindro, avanzar
+            if (current_sector >= DISK_SECTORS)
+            {
+                current_sector = 0;
+                current_cylinder++;
+
+                // Si se alcanzo el limite de cilindros, avanzar a siguiente pista
+                if (current_cylinder >= DISK_CYLINDERS)
+                {
+                    current_cylinder = 0;
+                    current_track++;
+
+                    // Si se alcanzo el limite de pistas, ERROR
+                    if (current_track >= DISK_TRACKS)
+                    {
+                        write_log(1, "LOADER ERROR: Disco lleno. No hay espacio para todas las palabras.\n");
+                        return -1;
+                    }
+                }
+            }
+        }
 
-        // Cada palabra se guarda en un sector separado (simplificado)
+        // Cada palabra se guarda en un sector separado (maximo 8 digitos segun WORD_DIGITS)
         memset(sector_buffer, 0, SECTOR_BYTES);
-        strncpy(sector_buffer, word_str, SECTOR_BYTES - 1);
+        snprintf(sector_buffer, SECTOR_BYTES, "%08d", word);
 
-        // Escribir en disco
-        if (disk_write_sector(current_track, current_cylinder, current_sector, sector_buffer) != 0)
+        // Escribir en disco a traves del cache
+        if (cache_write_sector(current_track, current_cylinder, current_sector, sector_buffer) != 0)
         {
             write_log(1, "LOADER ERROR: Fallo al escribir sector (%d,%d,%d).\n",
                       current_track, current_cylinder, current_sector);
             return -1;
         }
 
-        words_written++;
         write_log(0, "LOADER: Palabra %d escrita en sector (%d,%d,%d).\n",
-                  i, current_track, current_cylinder, current_sector);
-
-        // Avanzar al siguiente sector
-        current_sector++;
-
-        // Si se alcanzo el limite de sectores en un cilindro, avanzar
-        if (current_sector >= DISK_SECTORS)
-        {
-            current_sector = 0;
-            current_cylinder++;
-
-            // Si se alcanzo el limite de cilindros, avanzar a siguiente pista
-            if (current_cylinder >= DISK_CYLINDERS)
-            {
-                current_cylinder = 0;
-                current_track++;
+                  words_written, current_track, current_cylinder, current_sector);
+        words_written++;
+    }
 
-                // Si se alcanzo el limite de pistas, ERROR
-                if (current_track >= DISK_TRACKS)
-                {
-                    write_log(1, "LOADER ERROR: Disco lleno. No hay espacio para todas las palabras.\n");
-                    return -1;
-                }
-            }
-        }
+    // El programa queda en disco antes de registrarlo en la tabla de archivos persistente.
+    // cache_sync encola todos los sectores sucios juntos para que el disco los ordene
+    if (cache_sync() != 0)
+    {
+        write_log(1, "LOADER ERROR: Fallo al sincronizar el programa con el disco.\n");
+        return -1;
     }
 
     write_log(0, "LOADER: %d palabras escritas en disco exitosamente.\n", words_written);
@@ -201,11 +501,11 @@ static int read_program_from_disk(Word *words_buffer, int word_count,
     int current_sector = sector_start;
     int words_read = 0;
 
-    // Leer cada palabra del disco
+    // Leer cada palabra del disco (los sectores recientes salen del buffer cache)
     for (int i = 0; i < word_count; i++)
     {
         // Leer sector
-        if (disk_read_sector(current_track, current_cylinder, current_sector, sector_buffer) != 0)
+        if (cache_read_sector(current_track, current_cylinder, current_sector, sector_buffer, 3) != 0) // client_id = 3 (Loader)
         {
             write_log(1, "LOADER ERROR: Fallo al leer sector (%d,%d,%d).\n",
                       current_track, current_cylinder, current_sector);
@@ -213,6 +513,7 @@ static int read_program_from_disk(Word *words_buffer, int word_count,
         }
 
         // Convertir string a palabra
+        sector_buffer[SECTOR_BYTES - 1] = '\0';
         Word word = atoi(sector_buffer);
         words_buffer[i] = word;
         words_read++;
@@ -233,7 +534,7 @@ static int read_program_from_disk(Word *words_buffer, int word_count,
                 current_cylinder = 0;
                 current_track++;
 
-                if (current_track >= DISK_TRACKS)
+                if (current_track >= DISK_TRACKS && i + 1 < word_count)
                 {
                     write_log(1, "LOADER ERROR: Limite de disco alcanzado durante lectura.\n");
                     return -1;
@@ -247,91 +548,281 @@ static int read_program_from_disk(Word *words_buffer, int word_count,
 }
 
 /**
- * CARGAR DE PC REAL -> DISCO VIRTUAL
- *
- * Lee el codigo fuente y lo carga en disco
- * El programa queda en estado NEW en disco, sin ocupar RAM
- * Se llama desde con el comando CARGAR
+ * Escribe un programa ya parseado con el formato ExeHeader + palabras
  *
  * Flujo:
- *   1. Lee archivo .txt desde la pc (parsea directivas)
- *   2. Almacena palabras en buffer temporal
- *   3. Escribe todo en disco virtual usando disk_write_sector
- *   4. Crea PCB en tabla de procesos (Estado NEW)
- *   5. Agrega entrada en tabla de archivos (Estado DISK)
+ *   1. Escribe una cabecera provisional y luego las palabras, una tras otra
+ *   2. Reescribe la cabecera con la suma de verificacion final
  *
- * Parametros:
- *   filename: Ruta del archivo en PC real (ej: "Casos de prueba/prog1.txt")
- *   program_name: Nombre a asignar en tabla de archivos (ej: "prog1.txt")
- *   track, cylinder, sector: Ubicacion inicial en disco virtual
+ * Retorna: 0 si exito, -1 si error
+ */
+static int write_binary_image(const ProgramSource *src, const char *dst_filename)
+{
+    FILE *out = fopen(dst_filename, "wb");
+    if (!out)
+    {
+        write_log(1, "LOADER ERROR: No se pudo crear %s\n", dst_filename);
+        return -1;
+    }
+
+    ExeHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = EXE_MAGIC;
+    hdr.version = EXE_VERSION;
+    hdr.word_count = src->word_count;
+    hdr.n_start = src->n_start;
+    hdr.flags = (src->abi == ABI_REGISTERS) ? EXE_FLAG_REG_ABI : 0;
+    strncpy(hdr.name, src->prog_name, sizeof(hdr.name) - 1);
+
+    int status = (fwrite(&hdr, sizeof(hdr), 1, out) == 1) ? 0 : -1;
+
+    // La suma FNV-1a se calcula al vuelo sobre los bytes de cada palabra
+    uint32_t checksum = 2166136261u;
+    size_t pos = 0;
+    int word = 0;
+    while (status == 0 && source_next_word(src, &pos, &word))
+    {
+        int32_t w = word;
+        const unsigned char *bytes = (const unsigned char *)&w;
+        for (size_t i = 0; i < sizeof(w); i++)
+        {
+            checksum ^= bytes[i];
+            checksum *= 16777619u;
+        }
+        if (fwrite(&w, sizeof(w), 1, out) != 1)
+            status = -1;
+    }
+
+    hdr.checksum = checksum;
+    if (status == 0 && (fseek(out, 0, SEEK_SET) != 0 || fwrite(&hdr, sizeof(hdr), 1, out) != 1))
+        status = -1;
+
+    if (fclose(out) != 0)
+        status = -1;
+
+    if (status != 0)
+    {
+        write_log(1, "LOADER ERROR: Fallo al escribir %s\n", dst_filename);
+        return -1;
+    }
+    return 0;
+}
+
+// Ruta del ejecutable cacheado para un contenido dado: PROGRAM_CACHE_DIR/<hash>.bin
+static void progcache_path(uint64_t hash, char *out, size_t out_size)
+{
+    snprintf(out, out_size, "%s/%016llx.bin", PROGRAM_CACHE_DIR, (unsigned long long)hash);
+}
+
+/**
+ * Busca en la cache de programas el resultado de parsear un .txt con este hash.
+ * Si existe y es valido deja en *cached el ejecutable mapeado, listo para escribir a disco.
  *
- * Retorna: PID del proceso creado si exito, -1 si error
+ * Retorna: 1 si hubo acierto, 0 si no
  */
-int load_program_to_disk(const char *filename, const char *program_name,
-                         int track, int cylinder, int sector)
+static int progcache_lookup(uint64_t hash, ProgramSource *cached)
 {
-    write_log(1, "LOADER: ===== INICIANDO CARGA PC REAL -> DISCO =====\n");
-    write_log(1, "LOADER: Programa: %s, Archivo: %s\n", program_name, filename);
+    char path[300];
+    progcache_path(hash, path, sizeof(path));
+    if (access(path, R_OK) != 0)
+        return 0;
+
+    if (source_open(path, cached) != 0)
+        return 0;
+    if (!source_is_binary(cached) || parse_program_binary(cached, path) < 0)
+    {
+        // Entrada corrupta: se descarta y se vuelve a generar
+        source_close(cached);
+        unlink(path);
+        return 0;
+    }
+    return 1;
+}
 
-    // PASO 1: Leer archivo desde PC real
-    Word *words_buffer = (Word *)malloc(MAX_WORDS_BUFFER * sizeof(Word));
-    if (!words_buffer)
+/**
+ * Guarda en la cache de programas un .txt ya parseado.
+ * Se escribe a un temporal y se renombra, asi nunca queda una entrada a medias.
+ */
+static void progcache_store(uint64_t hash, const ProgramSource *src)
+{
+    if (mkdir(PROGRAM_CACHE_DIR, 0755) != 0 && access(PROGRAM_CACHE_DIR, W_OK) != 0)
+    {
+        write_log(0, "LOADER: No se pudo crear la cache de programas %s\n", PROGRAM_CACHE_DIR);
+        return;
+    }
+
+    // Varios hilos de carga pueden guardar el mismo contenido a la vez
+    static int tmp_counter = 0;
+    int tmp_id = __sync_fetch_and_add(&tmp_counter, 1);
+
+    char path[300], tmp_path[340];
+    progcache_path(hash, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.%d.tmp", path, (int)getpid(), tmp_id);
+
+    if (write_binary_image(src, tmp_path) != 0 || rename(tmp_path, path) != 0)
     {
-        write_log(1, "LOADER ERROR: Fallo al asignar buffer de palabras.\n");
+        unlink(tmp_path);
+        return;
+    }
+    write_log(0, "LOADER: '%s' guardado en la cache de programas (%s).\n", src->prog_name, path);
+}
+
+// Programa de la PC real ya parseado, pendiente de ubicar en el disco virtual
+typedef struct
+{
+    const char *filename; // NULL si no hay nada que parsear (el programa ya esta en disco)
+    ProgramSource src;
+    uint64_t hash;
+    long long source_mtime;
+    long long source_size;
+    int word_count; // -1 si fallo el parseo
+    int done;       // 1 cuando terminó la fase de parseo
+} LoadJob;
+
+/**
+ * FASE 1 DE LA CARGA: solo toca la PC real (archivo, cache de programas).
+ * No usa estructuras del kernel, por eso puede correr en un hilo de carga.
+ *
+ * Flujo:
+ *   1. Mapea el archivo .txt de la pc y calcula el hash de su contenido
+ *   2. Si el hash esta en la cache de programas usa el ejecutable ya parseado;
+ *      si no, cuenta palabras/directivas, valida la cantidad declarada y lo guarda en la cache
+ *
+ * Retorna: numero de palabras si exito, -1 si error (queda tambien en job->word_count)
+ */
+static int load_prepare(LoadJob *job)
+{
+    ProgramSource *src = &job->src;
+    job->word_count = -1;
+
+    if (source_open(job->filename, src) != 0)
+    {
+        write_log(1, "LOADER ERROR: Fallo al leer archivo.\n");
         return -1;
     }
 
-    int n_start = 0;
-    char prog_name[50] = {0};
-    int word_count = read_program_file(filename, words_buffer, &n_start, prog_name);
+    job->hash = source_hash(src);
+    job->source_mtime = src->mtime;
+    job->source_size = (long long)src->size;
+
+    int word_count;
+    ProgramSource cached;
+    if (source_is_binary(src))
+    {
+        word_count = parse_program_binary(src, job->filename);
+    }
+    else if (progcache_lookup(job->hash, &cached))
+    {
+        write_log(0, "LOADER: '%s' ya esta en la cache de programas (hash %016llx). No se vuelve a parsear.\n",
+                  job->filename, (unsigned long long)job->hash);
+        source_close(src);
+        *src = cached;
+        word_count = src->word_count;
+    }
+    else
+    {
+        word_count = parse_program_source(src, job->filename);
+        if (word_count >= 0)
+            progcache_store(job->hash, src);
+    }
 
     if (word_count < 0)
     {
         write_log(1, "LOADER ERROR: Fallo al leer archivo.\n");
-        free(words_buffer);
+        source_close(src);
         return -1;
     }
 
-    write_log(0, "LOADER: Archivo leido. %d palabras en buffer temporal.\n", word_count);
+    job->word_count = word_count;
+    return word_count;
+}
 
-    // PASO 2: Escribir en disco virtual
-    if (write_program_to_disk(words_buffer, word_count, track, cylinder, sector) != 0)
+/**
+ * FASE 2 DE LA CARGA: ubica en disco un programa ya parseado. Solo desde el hilo principal.
+ *
+ * Flujo:
+ *   1. Si otro programa del disco tiene el mismo contenido comparte su imagen;
+ *      si no, reserva un hueco contiguo y escribe las palabras (a traves del cache)
+ *   2. Crea PCB en tabla de procesos (Estado NEW)
+ *   3. Agrega entrada en tabla de archivos (Estado DISK) con hash, fecha y tamaño del archivo
+ *
+ * Retorna: PID del proceso creado si exito, -1 si error. Siempre libera el mapeo del job.
+ */
+static int load_place(LoadJob *job, const char *program_name)
+{
+    ProgramSource *src = &job->src;
+    int word_count = job->word_count;
+    int n_start = src->n_start;
+
+    // PASO 1: Reutilizar una imagen identica o reservar espacio contiguo y escribir en disco virtual
+    int track, cylinder, sector;
+    int first_lba = -1; // Solo se libera en caso de error si la imagen es propia
+    int same = file_table_find_by_hash(job->hash, word_count);
+    if (same != -1 && file_table[same].n_start == n_start)
     {
-        write_log(1, "LOADER ERROR: Fallo al escribir en disco.\n");
-        free(words_buffer);
-        return -1;
+        track = file_table[same].track;
+        cylinder = file_table[same].cylinder;
+        sector = file_table[same].sector_initial;
+        source_close(src);
+        write_log(0, "LOADER: Mismo contenido que '%s'. Se comparte su imagen en disco.\n",
+                  file_table[same].program_name);
     }
+    else
+    {
+        first_lba = diskmap_alloc(word_count);
+        if (first_lba < 0)
+        {
+            write_log(1, "LOADER ERROR: Disco lleno. No hay %d sectores contiguos libres.\n", word_count);
+            source_close(src);
+            return -1;
+        }
+
+        disk_from_lba(first_lba, &track, &cylinder, &sector);
 
-    write_log(0, "LOADER: Programa escrito en disco exitosamente.\n");
+        int written = write_program_to_disk(src, track, cylinder, sector);
+        source_close(src);
+        if (written != 0)
+        {
+            write_log(1, "LOADER ERROR: Fallo al escribir en disco.\n");
+            diskmap_free(first_lba, word_count);
+            return -1;
+        }
 
-    // PASO 3: Crear PCB en tabla de procesos (Estado NEW)
+        write_log(0, "LOADER: Programa escrito en disco exitosamente.\n");
+    }
+
+    // PASO 2: Crear PCB en tabla de procesos (Estado NEW)
     int pid = create_process(program_name, track, cylinder, sector, word_count);
     if (pid < 0)
     {
         write_log(1, "LOADER ERROR: Fallo al crear PCB.\n");
-        free(words_buffer);
+        if (first_lba >= 0)
+            diskmap_free(first_lba, word_count);
         return -1;
     }
 
     write_log(0, "LOADER: PCB creado. PID=%d\n", pid);
 
-    // PASO 4: Agregar entrada en tabla de archivos (Estado DISK)
+    // PASO 3: Agregar entrada en tabla de archivos (Estado DISK)
     int ft_index = file_table_add_entry(program_name, track, cylinder, sector, word_count, n_start);
     if (ft_index < 0)
     {
         write_log(1, "LOADER ERROR: Fallo al agregar entrada en tabla de archivos.\n");
-        free(words_buffer);
+        if (first_lba >= 0)
+            diskmap_free(first_lba, word_count);
         return -1;
     }
 
-    // Asociar el PID con la entrada de la tabla de archivos
-    file_table[ft_index].pid = pid;
+    // Asociar el PID y el archivo de origen con la entrada de la tabla de archivos
+    file_table_set_pid(ft_index, pid);
+    file_table[ft_index].content_hash = job->hash;
+    file_table[ft_index].source_mtime = job->source_mtime;
+    file_table[ft_index].source_size = job->source_size;
+    file_table[ft_index].abi = src->abi;
+    file_table_save();
 
     write_log(0, "LOADER: Entrada en tabla de archivos creada (indice %d).\n", ft_index);
 
-    // Liberar buffer temporal
-    free(words_buffer);
-
     write_log(1, "LOADER: ===== CARGA PC->DISCO COMPLETADA =====\n");
     write_log(1, "LOADER: PID=%d, Programa=%s, Palabras=%d, n_start=%d\n",
               pid, program_name, word_count, n_start);
@@ -339,6 +830,240 @@ int load_program_to_disk(const char *filename, const char *program_name,
     return pid;
 }
 
+/**
+ * CARGAR DE PC REAL -> DISCO VIRTUAL
+ *
+ * Lee el codigo fuente y lo carga en disco
+ * El programa queda en estado NEW en disco, sin ocupar RAM
+ * Se llama desde con el comando CARGAR
+ *
+ * Flujo: load_prepare (parseo en la PC real) y luego load_place (disco, PCB, tabla de archivos)
+ *
+ * Parametros:
+ *   filename: Ruta del archivo en PC real (ej: "Casos de prueba/prog1.txt")
+ *   program_name: Nombre a asignar en tabla de archivos (ej: "prog1.txt")
+ *
+ * Retorna: PID del proceso creado si exito, -1 si error
+ */
+int load_program_to_disk(const char *filename, const char *program_name)
+{
+    write_log(1, "LOADER: ===== INICIANDO CARGA PC REAL -> DISCO =====\n");
+    write_log(1, "LOADER: Programa: %s, Archivo: %s\n", program_name, filename);
+
+    LoadJob job;
+    memset(&job, 0, sizeof(job));
+    job.filename = filename;
+    if (load_prepare(&job) < 0)
+        return -1;
+
+    return load_place(&job, program_name);
+}
+
+// --- CARGA EN LOTE ---
+// Los hilos de carga parsean los archivos en paralelo; el hilo principal
+// los ubica en disco en orden con load_batch_commit.
+struct LoadBatch
+{
+    LoadJob *jobs;
+    int count;
+    int next_job; // Siguiente job que toma un hilo de carga
+    pthread_t workers[LOAD_WORKERS];
+    int n_workers;
+    pthread_mutex_t lock;
+    pthread_cond_t job_done;
+};
+
+static void *load_worker(void *arg)
+{
+    LoadBatch *batch = (LoadBatch *)arg;
+
+    while (1)
+    {
+        pthread_mutex_lock(&batch->lock);
+        int index = batch->next_job++;
+        pthread_mutex_unlock(&batch->lock);
+
+        if (index >= batch->count)
+            break;
+
+        LoadJob *job = &batch->jobs[index];
+        if (job->filename != NULL)
+            load_prepare(job);
+
+        pthread_mutex_lock(&batch->lock);
+        job->done = 1;
+        pthread_cond_broadcast(&batch->job_done);
+        pthread_mutex_unlock(&batch->lock);
+    }
+    return NULL;
+}
+
+LoadBatch *load_batch_start(char *const filenames[], int count)
+{
+    LoadBatch *batch = calloc(1, sizeof(LoadBatch));
+    if (batch == NULL)
+        return NULL;
+
+    batch->jobs = calloc(count > 0 ? count : 1, sizeof(LoadJob));
+    if (batch->jobs == NULL)
+    {
+        free(batch);
+        return NULL;
+    }
+    batch->count = count;
+    pthread_mutex_init(&batch->lock, NULL);
+    pthread_cond_init(&batch->job_done, NULL);
+
+    int pending = 0;
+    for (int i = 0; i < count; i++)
+    {
+        batch->jobs[i].filename = filenames[i];
+        batch->jobs[i].word_count = -1;
+        if (filenames[i] != NULL)
+            pending++;
+    }
+
+    // No hace falta un hilo por archivo: con LOAD_WORKERS el disco de la PC ya va a tope
+    int wanted = pending < LOAD_WORKERS ? pending : LOAD_WORKERS;
+    for (int i = 0; i < wanted; i++)
+    {
+        if (pthread_create(&batch->workers[batch->n_workers], NULL, load_worker, batch) == 0)
+            batch->n_workers++;
+    }
+
+    // Sin hilos (o sin nada que parsear) el hilo principal hace todo el trabajo
+    if (batch->n_workers == 0)
+        load_worker(batch);
+
+    write_log(0, "LOADER: Lote de %d programa(s), %d a parsear con %d hilo(s).\n",
+              count, pending, batch->n_workers);
+    return batch;
+}
+
+int load_batch_ready(LoadBatch *batch, int index)
+{
+    pthread_mutex_lock(&batch->lock);
+    int done = batch->jobs[index].done;
+    pthread_mutex_unlock(&batch->lock);
+    return done;
+}
+
+int load_batch_commit(LoadBatch *batch, int index, const char *program_name)
+{
+    LoadJob *job = &batch->jobs[index];
+
+    pthread_mutex_lock(&batch->lock);
+    while (!job->done)
+        pthread_cond_wait(&batch->job_done, &batch->lock);
+    pthread_mutex_unlock(&batch->lock);
+
+    if (job->filename == NULL || job->word_count < 0)
+        return -1;
+
+    write_log(1, "LOADER: ===== UBICANDO EN DISCO PROGRAMA YA PARSEADO =====\n");
+    write_log(1, "LOADER: Programa: %s, Archivo: %s\n", program_name, job->filename);
+
+    int pid = load_place(job, program_name);
+    job->word_count = -1; // El mapeo ya se libero
+    return pid;
+}
+
+void load_batch_destroy(LoadBatch *batch)
+{
+    if (batch == NULL)
+        return;
+
+    for (int i = 0; i < batch->n_workers; i++)
+        pthread_join(batch->workers[i], NULL);
+
+    // Programas parseados que nunca se ubicaron en disco
+    for (int i = 0; i < batch->count; i++)
+    {
+        if (batch->jobs[i].filename != NULL && batch->jobs[i].word_count >= 0)
+            source_close(&batch->jobs[i].src);
+    }
+
+    pthread_cond_destroy(&batch->job_done);
+    pthread_mutex_destroy(&batch->lock);
+    free(batch->jobs);
+    free(batch);
+}
+
+/**
+ * VERIFICAR SI EL ARCHIVO DE ORIGEN CAMBIO
+ *
+ * Primero compara fecha y tamaño (sin leer el archivo). Si difieren, calcula el hash:
+ * un archivo tocado pero con el mismo contenido no cuenta como cambio.
+ *
+ * Retorna: 1 si el contenido cambio, 0 si no cambio o no se puede leer
+ */
+int load_program_source_changed(int file_table_index, const char *filename)
+{
+    FileTableEntry *entry = get_file_table_entry(file_table_index);
+    if (entry == NULL || entry->content_hash == 0)
+        return 0;
+
+    struct stat st;
+    if (stat(filename, &st) != 0)
+        return 0; // Solo existe en el disco virtual
+
+    if ((long long)st.st_mtime == entry->source_mtime && (long long)st.st_size == entry->source_size)
+        return 0;
+
+    ProgramSource src;
+    if (source_open(filename, &src) != 0)
+        return 0;
+    uint64_t hash = source_hash(&src);
+    long long mtime = src.mtime;
+    source_close(&src);
+
+    if (hash != entry->content_hash)
+    {
+        write_log(0, "LOADER: '%s' cambio desde la ultima carga.\n", filename);
+        return 1;
+    }
+
+    // Mismo contenido: solo se actualiza la fecha para no volver a calcular el hash
+    entry->source_mtime = mtime;
+    entry->source_size = (long long)st.st_size;
+    file_table_save();
+    return 0;
+}
+
+/**
+ * CONVERTIR .txt -> EJECUTABLE BINARIO
+ *
+ * Flujo:
+ *   1. Mapea y parsea el .txt (mismas reglas que la carga normal)
+ *   2. Escribe cabecera y palabras (ver write_binary_image)
+ *
+ * Retorna: cantidad de palabras escritas si exito, -1 si error
+ */
+int convert_program_to_binary(const char *src_filename, const char *dst_filename)
+{
+    ProgramSource src;
+    if (source_open(src_filename, &src) != 0)
+        return -1;
+
+    if (source_is_binary(&src))
+    {
+        write_log(1, "LOADER ERROR: %s ya es un ejecutable binario.\n", src_filename);
+        source_close(&src);
+        return -1;
+    }
+
+    int word_count = parse_program_source(&src, src_filename);
+    if (word_count < 0 || write_binary_image(&src, dst_filename) != 0)
+    {
+        source_close(&src);
+        return -1;
+    }
+    source_close(&src);
+
+    write_log(0, "LOADER: %s convertido a %s (%d palabras).\n", src_filename, dst_filename, word_count);
+    return word_count;
+}
+
 /**
  * CARGAR DE DISCO VIRTUAL -> RAM
  *
@@ -385,6 +1110,14 @@ int load_program_to_ram(int pid, int partition_id, int file_table_index)
     write_log(0, "LOADER: Cargando '%s' (PID=%d) a RAM (Particion %d).\n",
               entry->program_name, pid, partition_id);
 
+    // Sin limite de palabras en disco, pero en RAM el programa debe caber en su particion
+    if (entry->size_words > PARTITION_SIZE)
+    {
+        write_log(1, "LOADER ERROR: '%s' tiene %d palabras y la particion solo %d.\n",
+                  entry->program_name, entry->size_words, PARTITION_SIZE);
+        return -1;
+    }
+
     // PASO 1: Leer programa desde disco a buffer temporal
     Word *words_buffer = (Word *)malloc(entry->size_words * sizeof(Word));
     if (!words_buffer)
@@ -437,6 +1170,7 @@ int load_program_to_ram(int pid, int partition_id, int file_table_index)
     pcb->context.RL = limit_address;      // Registro Limite (final de particion)
     pcb->context.PSW.PC = entry->n_start; // Program Counter (dentro de PSW)
     pcb->context.SP = sp_initial;         // Stack Pointer (final de particion)
+    pcb->abi = entry->abi;                // Convencion de las syscalls del programa
 
     // Configuracion del PSW (Program Status Word)
     pcb->context.PSW.Mode = USER_MODE; // Modo usuario
@@ -458,6 +1192,7 @@ int load_program_to_ram(int pid, int partition_id, int file_table_index)
     // PASO 5: Actualizar estado en tabla de archivos
     entry->state = FILE_STATE_READY;
     entry->partition_id = partition_id;
+    file_table_set_pid(file_table_index, pid);
 
     // PASO 6: Actualizar estado en PCB
     pcb->partition_id = partition_id;
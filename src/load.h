@@ -2,6 +2,31 @@
 #define LOAD_H
 
 #include "brain.h"
+#include <stdint.h>
+
+// --- FORMATO EJECUTABLE BINARIO ---
+// Cabecera seguida de word_count palabras de 32 bits (int32_t), ya sin texto que parsear
+#define EXE_MAGIC 0x58454B4D // "MKEX" en little endian
+#define EXE_VERSION 1
+
+#define EXE_FLAG_REG_ABI 0x0001 // .ABI registros: syscalls con el parámetro en RX (ver kernel.h)
+
+// Cache de programas ya parseados en la PC real: <hash del .txt>.bin con el formato de abajo
+#define PROGRAM_CACHE_DIR ".progcache"
+
+// Hilos que parsean en paralelo los archivos de un EJECUTAR con varios programas
+#define LOAD_WORKERS 4
+
+typedef struct
+{
+    uint32_t magic;     // EXE_MAGIC
+    uint16_t version;   // EXE_VERSION
+    uint16_t flags;     // EXE_FLAG_*
+    char name[48];      // .NombreProg
+    int32_t word_count; // Palabras del programa
+    int32_t n_start;    // Indice _start (base 0)
+    uint32_t checksum;  // FNV-1a de las palabras
+} ExeHeader;
 
 typedef struct
 {
@@ -13,7 +38,10 @@ typedef struct
 /**
  * CARGAR DE PC REAL -> DISCO VIRTUAL
  * 
- * Lee un archivo .txt desde la PC real y lo carga completamente en disco
+ * Lee un archivo .txt (o un ejecutable binario, ver ExeHeader) desde la PC real
+ * y lo carga completamente en disco
+ * en el hueco libre contiguo más pequeño donde quepa (ver diskmap.h)
+ * Un .txt ya visto (mismo hash) se toma de PROGRAM_CACHE_DIR sin volver a parsearlo
  * El programa queda en estado NEW en disco sin ocupar RAM
  * 
  * Se llama desde: comando CARGAR
@@ -21,12 +49,46 @@ typedef struct
  * Parámetros:
  *   filename: Ruta del archivo en PC real (ej: "Casos de prueba/prog1.txt")
  *   program_name: Nombre a asignar en tabla de archivos (ej: "prog1.txt")
- *   track, cylinder, sector: Ubicación inicial en disco virtual
  * 
  * Retorna: PID del proceso creado si éxito, -1 si error
  */
-int load_program_to_disk(const char *filename, const char *program_name,
-                          int track, int cylinder, int sector);
+int load_program_to_disk(const char *filename, const char *program_name);
+
+/**
+ * CARGA EN LOTE (PIPELINE DE EJECUTAR)
+ *
+ * load_batch_start lanza hasta LOAD_WORKERS hilos que parsean los archivos en paralelo
+ * (filenames[i] == NULL: nada que parsear, el programa ya está en disco).
+ * load_batch_commit ubica en disco el programa i, esperando su parseo si hace falta;
+ * se llama en orden desde el hilo principal, igual que load_program_to_disk.
+ * load_batch_ready consulta sin bloquear si el parseo del programa i ya terminó.
+ */
+typedef struct LoadBatch LoadBatch;
+
+LoadBatch *load_batch_start(char *const filenames[], int count); // NULL si no hay memoria
+int load_batch_ready(LoadBatch *batch, int index);                // 1 si ya se puede ubicar
+int load_batch_commit(LoadBatch *batch, int index, const char *program_name); // PID o -1
+void load_batch_destroy(LoadBatch *batch); // Espera a los hilos y libera lo que no se ubicó
+
+/**
+ * VERIFICAR SI EL ARCHIVO DE ORIGEN CAMBIO
+ *
+ * Compara el archivo de la PC real con la fecha, tamaño y hash guardados
+ * en la tabla de archivos cuando se cargó al disco.
+ *
+ * Retorna: 1 si el contenido cambió (hay que recargarlo), 0 si no
+ */
+int load_program_source_changed(int file_table_index, const char *filename);
+
+/**
+ * CONVERTIR .txt -> EJECUTABLE BINARIO
+ *
+ * Parsea un programa en formato texto y lo guarda con el formato ExeHeader + palabras.
+ * load_program_to_disk reconoce el binario por su número mágico y lo carga sin parsear.
+ *
+ * Retorna: cantidad de palabras escritas si éxito, -1 si error
+ */
+int convert_program_to_binary(const char *src_filename, const char *dst_filename);
 
 /**
  * CARGAR DE DISCO VIRTUAL -> RAM
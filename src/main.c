@@ -10,10 +10,15 @@
 #include "bus.h"
 #include "memory.h"
 #include "disk.h"
+#include "cache.h"
+#include "diskmap.h"
 #include "dma.h"
 #include "load.h"
 #include "log.h"
 #include "kernel.h"
+#include "console.h"
+#include "shm.h"
+#include "pipe.h"
 
 #define USER_PROGRAM_START 300
 #define SYSTEM_STACK_START 299
@@ -31,6 +36,8 @@ void print_registers()
            context.RX, context.SP, (context.PSW.Mode == 0 ? "USER" : "KERNEL"));
     printf(" RB: %08d | RL: %08d | CC: %d\n",
            context.RB, context.RL, context.PSW.CC);
+    printf(" R0-R3: %08d %08d %08d %08d\n", context.R[0], context.R[1], context.R[2], context.R[3]);
+    printf(" R4-R7: %08d %08d %08d %08d\n", context.R[4], context.R[5], context.R[6], context.R[7]);
     printf("------------------------------------------------\n");
 }
 
@@ -70,6 +77,18 @@ int system_init()
         write_log(1, "FATAL: No se pudo iniciar el disco. Saliendo...\n");
         return -1;
     }
+    // Inicia el buffer cache del disco
+    if (cache_init() != 0)
+    {
+        write_log(1, "FATAL: No se pudo iniciar el buffer cache. Saliendo...\n");
+        return -1;
+    }
+    // Inicia el hilo lector de la consola
+    if (console_init() != 0)
+    {
+        write_log(1, "FATAL: No se pudo iniciar la consola. Saliendo...\n");
+        return -1;
+    }
     // Inicia el módulo DMA
     if (dma_init() != 0)
     {
@@ -92,18 +111,32 @@ static void print_banner()
     printf("  memestat                               - Muestra el estado de la memoria\n");
     printf("  apagar                                 - Apaga el sistema y cierra el simulador\n");
     printf("  reiniciar                              - Reinicia el sistema sin cerrar\n");
-    printf("==============================================\n\n");
+    printf("  borrar <programa>                      - Elimina un programa del disco\n");
+    printf("  convertir <origen.txt> <destino>       - Genera el ejecutable binario de un programa\n");
+    printf("  formatear                              - Borra los programas guardados en el disco\n");
+    printf("  diskstat [fcfs|sstf|scan|clook]        - Estadisticas del disco / cambia su planificacion\n");
+    printf("  cachestat                              - Aciertos y fallos del buffer cache del disco\n");
+    printf("  sync                                   - Escribe al disco los sectores modificados\n");
+    printf("  entrada [archivo]                      - Entrada de los procesos desde un archivo (sin archivo: consola)\n");
+    printf("  salida [programa [archivo]]            - Salida de un programa a un archivo (sin archivo: consola)\n");
+    printf("  ipcs                                   - Segmentos de memoria compartida y tubos\n");
+    printf("==============================================\n");
+    printf("Disco: %s (%d programa(s) guardados)\n\n", disk_get_image_path(), file_table_count);
 }
 
 // Comando APAGAR: Apaga el sistema de forma ordenada
 void cmd_apagar()
 {
     printf("Apagando sistema...\n");
+    console_output_flush_all();
 
     // Liberar recursos en orden específico
     dma_destroy();
+    cache_destroy();   // Escribe al disco los sectores sucios
+    file_table_save(); // La tabla de archivos queda en la imagen del disco
     disk_destroy();
     bus_destroy();
+    console_destroy();
     log_close();
 }
 
@@ -118,11 +151,15 @@ void cmd_reiniciar()
     // Resetear registros del CPU
     cpu_init();
 
-    // Reinicializar estructuras del kernel
-    kernel_init_structures();
-
-    // Reinicializar disco virtual
+    // Reabrir el disco virtual (la imagen conserva los programas ya cargados)
+    cache_destroy();
+    file_table_save();
+    disk_destroy();
     disk_init();
+    cache_init();
+
+    // Reinicializar estructuras del kernel (recupera la tabla de archivos del disco)
+    kernel_init_structures();
 
     // Reinicializar controlador DMA
     dma_init();
@@ -133,9 +170,251 @@ void cmd_reiniciar()
     printf("Sistema reiniciado correctamente.\n");
 }
 
+// Comando FORMATEAR: Borra el disco virtual y la tabla de archivos
+void cmd_formatear()
+{
+    cache_invalidate();
+    if (disk_format() != 0)
+    {
+        printf("Error: No se pudo formatear el disco.\n");
+        return;
+    }
+    kernel_init_structures();
+    printf("Disco formateado. No hay programas guardados.\n");
+}
+
+// Comando DISKSTAT: Muestra la cola del disco y, con argumento, cambia la política
+void cmd_diskstat(const char *arg)
+{
+    while (*arg == ' ')
+        arg++;
+
+    if (*arg != '\0')
+    {
+        int new_policy = disk_policy_from_name(arg);
+        if (new_policy == -1)
+        {
+            printf("Politica desconocida '%s'. Use: fcfs, sstf, scan o clook.\n", arg);
+            return;
+        }
+        disk_set_policy((DiskSchedPolicy)new_policy);
+        disk_reset_stats();
+        printf("Planificacion del disco: %s\n", disk_policy_name(disk_get_policy()));
+        return;
+    }
+
+    DiskStats st;
+    disk_get_stats(&st);
+
+    printf("\n============== ESTADO DEL DISCO ==============\n");
+    printf(" Imagen            : %s\n", disk_get_image_path());
+    printf(" Planificacion     : %s\n", disk_policy_name(disk_get_policy()));
+    printf(" Posicion del brazo: cilindro logico %d\n", st.head);
+    printf(" Peticiones        : %ld (cola maxima %d)\n", st.requests, st.max_queue);
+    if (st.requests > 0)
+    {
+        printf(" Busqueda promedio : %.2f cilindros\n", (double)st.seek_distance / st.requests);
+        printf(" Espera promedio   : %.1f us en cola\n", (double)st.wait_us / st.requests);
+        printf(" Servicio promedio : %.1f us (busqueda + rotacion + transferencia)\n",
+               (double)st.service_us / st.requests);
+    }
+
+    DiskMapStats map;
+    diskmap_get_stats(&map);
+    printf(" Sectores libres   : %d / %d (%d programa(s) guardados)\n",
+           map.free_sectors, map.total_sectors, file_table_count);
+    printf(" Huecos libres     : %d (mayor: %d sectores)\n", map.free_extents, map.largest_extent);
+    printf(" Fragmentacion     : %.1f%%\n", map.fragmentation);
+    printf("==============================================\n\n");
+}
+
+// Comando CACHESTAT: Muestra los contadores del buffer cache
+void cmd_cachestat()
+{
+    CacheStats st;
+    cache_get_stats(&st);
+    long accesses = st.hits + st.misses;
+
+    printf("\n============== BUFFER CACHE DEL DISCO ==============\n");
+    printf(" Bloques en uso : %d / %d (%d sucios)\n", st.used, CACHE_BLOCKS, st.dirty);
+    printf(" Aciertos       : %ld\n", st.hits);
+    printf(" Fallos         : %ld\n", st.misses);
+    if (accesses > 0)
+    {
+        printf(" Tasa de acierto: %5.1f%%\n", 100.0 * st.hits / accesses);
+    }
+    printf(" Lectura anticipada: %ld sector(es) pedidos, %ld usados\n", st.readahead, st.ra_hits);
+    printf(" Desalojos      : %ld\n", st.evictions);
+    printf(" Escrituras al disco (write-back): %ld\n", st.writebacks);
+    printf("====================================================\n\n");
+}
+
+// Comando SYNC: Fuerza la escritura de los sectores sucios del cache
+void cmd_sync()
+{
+    if (cache_sync() == 0 && disk_sync() == 0)
+    {
+        printf("Disco sincronizado.\n");
+    }
+    else
+    {
+        printf("Error: No se pudo sincronizar el disco.\n");
+    }
+}
+
+// Comando BORRAR: Elimina un programa del disco virtual y libera sus sectores
+void cmd_borrar(const char *arg)
+{
+    while (*arg == ' ')
+        arg++;
+
+    if (*arg == '\0')
+    {
+        printf("Uso: borrar <programa>\n");
+        return;
+    }
+
+    int file_index = file_table_search_by_name(arg);
+    if (file_index == -1)
+    {
+        printf("Programa '%s' no encontrado en disco.\n", arg);
+        return;
+    }
+
+    if (file_table_remove(file_index) != 0)
+    {
+        printf("Error: No se pudo borrar '%s' (esta en ejecucion).\n", arg);
+        return;
+    }
+    printf("Programa '%s' borrado del disco.\n", arg);
+}
+
+// Comando CONVERTIR: Genera el ejecutable binario (.bin) de un programa en texto
+void cmd_convertir(const char *args)
+{
+    char origen[256], destino[256];
+    if (sscanf(args, "%255s %255s", origen, destino) != 2)
+    {
+        printf("Uso: convertir <origen.txt> <destino>\n");
+        return;
+    }
+
+    int words = convert_program_to_binary(origen, destino);
+    if (words < 0)
+    {
+        printf("Error: No se pudo convertir '%s'.\n", origen);
+        return;
+    }
+    printf("Ejecutable '%s' generado (%d palabras).\n", destino, words);
+}
+
+// Comando ENTRADA: Los procesos leen (syscall 3) de un archivo en vez de la consola
+void cmd_entrada(const char *arg)
+{
+    while (*arg == ' ')
+        arg++;
+
+    if (*arg == '\0')
+    {
+        console_set_input_file(NULL);
+        printf("Entrada de los procesos: consola.\n");
+        return;
+    }
+
+    if (console_set_input_file(arg) != 0)
+    {
+        printf("Error: No se pudo abrir '%s'.\n", arg);
+        return;
+    }
+    printf("Entrada de los procesos: %s (al terminarse se vuelve a la consola).\n", arg);
+}
+
+// Comando SALIDA: Lo que imprime un programa (syscall 2) va a un archivo en vez de la consola
+void cmd_salida(const char *arg)
+{
+    char programa[256] = "", archivo[256] = "";
+    int n = sscanf(arg, "%255s %255s", programa, archivo);
+
+    if (n < 1)
+    {
+        console_print_redirects();
+        return;
+    }
+
+    if (n == 1)
+    {
+        console_set_output_file(programa, NULL);
+        printf("Salida de '%s': consola.\n", programa);
+        return;
+    }
+
+    if (console_set_output_file(programa, archivo) != 0)
+    {
+        printf("Error: Hay demasiadas redirecciones (maximo %d).\n", CONSOLE_MAX_REDIRECTS);
+        return;
+    }
+    printf("Salida de '%s': %s (se agrega al final del archivo).\n", programa, archivo);
+}
+
+// Comando IPCS: Muestra los segmentos de memoria compartida y los tubos, y qué procesos los usan
+void cmd_ipcs()
+{
+    printf("\n--- MEMORIA COMPARTIDA (%d segmentos de %d palabras, Dir %d a %d) ---\n",
+           SHM_MAX_SEGMENTS, SHM_SEGMENT_WORDS, SHM_POOL_START, SHM_POOL_START + SHM_POOL_WORDS - 1);
+    printf("%-3s | %-8s | %-11s | %-5s | %s\n", "ID", "CLAVE", "DIRECCION", "REFS", "PROCESOS (* = adjuntado)");
+    printf("----+----------+-------------+-------+--------------------------\n");
+
+    int shown = 0;
+    for (int i = 0; i < SHM_MAX_SEGMENTS; i++)
+    {
+        ShmInfo seg;
+        if (shm_get_info(i, &seg) != 0 || !seg.in_use)
+            continue;
+
+        printf("%-3d | %-8d | %04d a %04d | %-5d |", i, seg.key, seg.base, seg.base + seg.size - 1, seg.refs);
+        for (int pid = kernel_first_process(); pid != NULL_PID; pid = kernel_next_process(pid))
+        {
+            if (get_pcb(pid)->shm_id == i)
+                printf(" %d%s", pid, process_context(pid)->SL > 0 ? "*" : "");
+        }
+        printf("\n");
+        shown++;
+    }
+    if (shown == 0)
+        printf("(ningun segmento en uso)\n");
+
+    printf("\n--- TUBOS (%d de %d palabras, Dir %d a %d) ---\n",
+           PIPE_MAX, PIPE_CAPACITY, PIPE_POOL_START, PIPE_POOL_START + PIPE_POOL_WORDS - 1);
+    printf("%-3s | %-8s | %-9s | %-5s | %-19s | %s\n", "ID", "CLAVE", "OCUPADAS", "L / E", "ESCRITAS / LEIDAS", "ESPERANDO");
+    printf("----+----------+-----------+-------+---------------------+----------\n");
+
+    shown = 0;
+    for (int i = 0; i < PIPE_MAX; i++)
+    {
+        PipeInfo p;
+        if (pipe_get_info(i, &p) != 0 || !p.in_use)
+            continue;
+
+        printf("%-3d | %-8d | %4d / %-2d | %2d/%-2d | %8ld / %-8ld |", i, p.key, p.count, PIPE_CAPACITY, p.readers,
+               p.writers, p.words_in, p.words_out);
+        for (int pid = kernel_first_process(); pid != NULL_PID; pid = kernel_next_process(pid))
+        {
+            PCBHot *hot = get_pcb_hot(pid);
+            if (hot->state == STATE_BLOCKED && hot->wait_reason == WAIT_PIPE && hot->wait_object == i)
+                printf(" %d", pid);
+        }
+        printf("\n");
+        shown++;
+    }
+    if (shown == 0)
+        printf("(ningun tubo en uso)\n");
+    printf("\n");
+}
+
 // Comando MEMESTAT: Muestra el estado de las particiones de memoria RAM
 void cmd_memestat()
 {
+    console_output_flush_all();
     printf("\n============== ESTADO DE LA MEMORIA RAM ==============\n");
     printf(" Memoria Total  : %d palabras\n", MEM_SIZE);
 
@@ -143,6 +422,16 @@ void cmd_memestat()
     float so_percent = ((float)MEM_USER_START / (float)MEM_SIZE) * 100.0f;
     printf(" [Dir %04d a %04d] SISTEMA OPERATIVO - Ocupada - %5.1f%%\n", 0, MEM_USER_START - 1, so_percent);
 
+    int shm_used = 0;
+    ShmInfo seg;
+    for (int i = 0; i < SHM_MAX_SEGMENTS; i++)
+    {
+        if (shm_get_info(i, &seg) == 0 && seg.in_use)
+            shm_used++;
+    }
+    printf("   [Dir %04d a %04d] Memoria compartida: %d de %d segmento(s) en uso\n",
+           SHM_POOL_START, SHM_POOL_START + SHM_POOL_WORDS - 1, shm_used, SHM_MAX_SEGMENTS);
+
     // Particiones de Usuario
     float part_percent = ((float)PARTITION_SIZE / (float)MEM_SIZE) * 100.0f;
 
@@ -155,10 +444,10 @@ void cmd_memestat()
         {
             // Opcional: Buscar qué PID es dueño de esta partición
             int owner_pid = -1;
-            for (int j = 0; j < MAX_PROCESSES; j++)
+            for (int j = kernel_first_process(); j != NULL_PID; j = kernel_next_process(j))
             {
                 PCB *p = get_pcb(j);
-                if (p != NULL && p->partition_id == i && p->state != STATE_TERMINATED)
+                if (p->partition_id == i)
                 {
                     owner_pid = p->pid;
                     break;
@@ -176,23 +465,32 @@ void cmd_memestat()
     printf("======================================================\n\n");
 }
 
-// Comando PS: Muestra el estado de todos los procesos
-void cmd_ps()
+// Función auxiliar: Resumen de cambios de contexto y de la salida de los procesos (para PS)
+static void print_runtime_stats()
 {
-    // Contar procesos activos
-    int count = 0;
-    for (int i = 0; i < MAX_PROCESSES; i++)
-    {
-        PCB *pcb = get_pcb(i);
-        if (pcb != NULL)
-        {
-            count++;
-        }
-    }
+    CtxSwitchStats sw;
+    cpu_get_switch_stats(&sw);
+    printf(" Cambios de contexto: %ld (%.0f ns promedio), %ld interrupciones sin copiar contexto.\n",
+           sw.switches, sw.switches > 0 ? (double)sw.total_ns / sw.switches : 0.0, sw.avoided);
+
+    ConsoleOutputStats out;
+    console_get_output_stats(&out);
+    printf(" Salida de procesos: %ld valor(es) en %ld escritura(s), %ld bytes (%.0f valores/s).\n",
+           out.values, out.flushes, out.bytes, out.rate);
+}
 
-    if (count == 0)
+// Comando PS: Muestra el estado de todos los procesos vivos
+// (los terminados sólo se cuentan, con miles de procesos la lista sería enorme)
+void cmd_ps()
+{
+    console_output_flush_all();
+    if (kernel_first_process() == NULL_PID)
     {
-        printf("No hay procesos en el sistema.\n");
+        if (kernel_terminated_count() > 0)
+            printf("No hay procesos vivos (%d terminado(s)).\n", kernel_terminated_count());
+        else
+            printf("No hay procesos en el sistema.\n");
+        print_runtime_stats();
         return;
     }
 
@@ -201,49 +499,134 @@ void cmd_ps()
            "PID", "NOMBRE", "ESTADO", "MEMORIA%");
     printf("------+----------------------+--------------+------------\n");
 
-    // Mostrar cada proceso
-    for (int i = 0; i < MAX_PROCESSES; i++)
+    // Mostrar cada proceso vivo
+    for (int i = kernel_first_process(); i != NULL_PID; i = kernel_next_process(i))
     {
         PCB *pcb = get_pcb(i);
+        ProcessState state = get_pcb_hot(i)->state;
 
-        if (pcb != NULL)
+        // Calcular porcentaje de memoria basado en el tamaño real del programa
+        float mem_percent = 0.0f;
+        // Si el proceso ya está en RAM (no está solo en el disco)
+        if (state == STATE_READY || state == STATE_RUNNING || state == STATE_BLOCKED)
         {
-            // Calcular porcentaje de memoria basado en el tamaño real del programa
-            float mem_percent = 0.0f;
-            // Si el proceso ya está en RAM (no está solo en el disco)
-            if (pcb->state == STATE_READY || pcb->state == STATE_RUNNING || pcb->state == STATE_BLOCKED)
-            {
-                mem_percent = ((float)PARTITION_SIZE / (float)MEM_SIZE) * 100.0f;
-            }
+            mem_percent = ((float)PARTITION_SIZE / (float)MEM_SIZE) * 100.0f;
+        }
 
-            // Obtener estado como string
-            const char *estado = state_to_string(pcb->state);
+        // Obtener estado como string
+        const char *estado = state_to_string(state);
 
-            // Mostrar fila
-            printf("%-5d | %-20s | %-12s | %9.1f%%\n",
-                   pcb->pid, pcb->name, estado, mem_percent);
-        }
+        // Mostrar fila
+        printf("%-5d | %-20s | %-12s | %9.1f%%\n",
+               pcb->pid, pcb->name, estado, mem_percent);
     }
 
+    printf("\n %d en RAM, %d terminado(s) desde el último reinicio.\n",
+           kernel_active_count(), kernel_terminated_count());
+    print_runtime_stats();
     printf("\n");
 }
 
 // Función auxiliar: Verifica si hay procesos activos en el sistema
 bool hay_procesos_activos()
 {
-    for (int i = 0; i < MAX_PROCESSES; i++)
+    return kernel_active_count() > 0;
+}
+
+// Función auxiliar: Verifica si queda alguna partición de RAM libre (sin reservarla)
+static bool hay_particion_libre()
+{
+    for (int i = 0; i < NUM_PARTITIONS; i++)
     {
-        PCB *pcb = get_pcb(i);
-        if (pcb != NULL &&
-            (pcb->state == STATE_READY || pcb->state == STATE_RUNNING || pcb->state == STATE_BLOCKED))
-        {
+        if (!partitions_bitmap[i])
             return true;
-        }
     }
     return false;
 }
 
+/**
+ * Pasa un programa del lote a RAM: lo ubica en disco (si hacía falta), crea el PCB
+ * y lo carga en una partición. El parseo ya lo hizo un hilo de carga.
+ *
+ * Retorna: PID listo para ejecutar, o -1 si no se pudo cargar
+ */
+static int admitir_programa(LoadBatch *batch, int index, const char *program_name)
+{
+    printf("\n--- Cargando programa: %s ---\n", program_name);
+
+    // El mismo nombre puede aparecer dos veces en la lista: la segunda vez ya está en disco
+    int file_index = file_table_search_by_name(program_name);
+    int pid = -1;
+
+    if (file_index == -1)
+    {
+        // Paso 4: No existe, pasarlo de la PC real al Disco (ya viene parseado)
+        printf("Programa no encontrado en disco. Cargando desde archivo...\n");
+
+        pid = load_batch_commit(batch, index, program_name);
+        if (pid == -1)
+        {
+            printf("Error: No se pudo cargar '%s' al disco.\n", program_name);
+            return -1;
+        }
+
+        printf("Programa cargado a disco con PID %d.\n", pid);
+
+        // Actualizar file_index después de cargar
+        file_index = file_table_search_by_name(program_name);
+    }
+    else
+    {
+        // Paso 5: Ya existe en disco, crear nuevo PCB
+        FileTableEntry *entry = get_file_table_entry(file_index);
+
+        if (entry == NULL)
+        {
+            printf("Error: No se pudo obtener información del programa '%s'.\n", program_name);
+            return -1;
+        }
+
+        pid = create_process(program_name, entry->track, entry->cylinder,
+                             entry->sector_initial, entry->size_words);
+
+        if (pid == -1)
+        {
+            printf("Error: No se pudo crear el proceso para '%s'.\n", program_name);
+            return -1;
+        }
+
+        printf("Proceso creado con PID %d.\n", pid);
+    }
+
+    // Paso 6: Buscar partición libre
+    int partition_id = find_free_partition();
+
+    if (partition_id == -1)
+    {
+        kernel_terminate_process(pid); // El PCB no llegó a RAM
+        printf("Error: No hay memoria RAM disponible para '%s'.\n", program_name);
+        return -1;
+    }
+
+    printf("Partición %d asignada.\n", partition_id);
+
+    // Paso 7: Cargar a RAM
+    if (load_program_to_ram(pid, partition_id, file_index) != 0)
+    {
+        partitions_bitmap[partition_id] = false; // Devolver la partición
+        kernel_terminate_process(pid);
+        printf("Error: No se pudo cargar '%s' a memoria RAM.\n", program_name);
+        return -1;
+    }
+
+    printf("Programa '%s' cargado en RAM.\n", program_name);
+    printf("Proceso %d (%s) listo para ejecutar.\n", pid, program_name);
+    return pid;
+}
+
 // Comando EJECUTAR: Carga y ejecuta una lista de programas
+// Los archivos se parsean en paralelo (ver load_batch_start) y el primer programa
+// empieza a ejecutar mientras los siguientes todavía se están cargando.
 void cmd_ejecutar(const char *program_list_arg)
 {
     // Paso 1: Validar entrada
@@ -259,119 +642,82 @@ void cmd_ejecutar(const char *program_list_arg)
         return;
     }
 
-    // Paso 2: Parsear y cargar cada programa
+    // Paso 2: Tokenizar la lista de programas
     char program_names[256];
     strncpy(program_names, p, sizeof(program_names) - 1);
     program_names[sizeof(program_names) - 1] = '\0';
 
-    // Tokenizar la lista de programas
-    char *token = strtok(program_names, " \t");
-    int programs_loaded = 0;
-    static int proxima_pista_libre = 0;
+    char *names[sizeof(program_names) / 2];
+    char *to_parse[sizeof(program_names) / 2];
+    int n_programs = 0;
 
-    while (token != NULL)
+    for (char *token = strtok(program_names, " \t"); token != NULL; token = strtok(NULL, " \t"))
     {
-        char program_name[256];
-        strncpy(program_name, token, sizeof(program_name) - 1);
-        program_name[sizeof(program_name) - 1] = '\0';
-
-        printf("\n--- Cargando programa: %s ---\n", program_name);
-
-        // Paso 3: Verificar si existe en File_Table
-        int file_index = file_table_search_by_name(program_name);
-        int pid = -1;
+        names[n_programs] = token;
 
-        if (file_index == -1)
+        // Paso 3: Verificar si existe en File_Table (y si el archivo de la PC real cambió)
+        int file_index = file_table_search_by_name(token);
+        if (file_index != -1 && load_program_source_changed(file_index, token))
         {
-            // Paso 4: No existe, cargar desde PC real a Disco
-            printf("Programa no encontrado en disco. Cargando desde archivo...\n");
-
-            // Construir ruta del archivo (en carpeta src/)
-            char filepath[300];
-            snprintf(filepath, sizeof(filepath), "%s", program_name);
-
-            // Cargar a disco (track=0, cylinder=0, sector=0 por defecto)
-            pid = load_program_to_disk(filepath, program_name, proxima_pista_libre, 0, 0);
-
-            if (pid != -1)
+            if (file_table_remove(file_index) == 0)
             {
-                proxima_pista_libre++; // Avanzamos a la siguiente pista para el próximo programa
+                printf("El archivo '%s' cambió desde la última carga. Recargando...\n", token);
+                file_index = -1;
             }
-
-            printf("Programa cargado a disco con PID %d.\n", pid);
-
-            // Actualizar file_index después de cargar
-            file_index = file_table_search_by_name(program_name);
-        }
-        else
-        {
-            // Paso 5: Ya existe en disco, crear nuevo PCB
-            FileTableEntry *entry = get_file_table_entry(file_index);
-
-            if (entry == NULL)
+            else
             {
-                printf("Error: No se pudo obtener información del programa '%s'.\n", program_name);
-                token = strtok(NULL, " \t");
-                continue;
+                printf("Aviso: '%s' cambió pero está en uso; se ejecuta la versión del disco.\n", token);
             }
+        }
 
-            pid = create_process(program_name, entry->track, entry->cylinder,
-                                 entry->sector_initial, entry->size_words);
+        // Sólo se parsean los que no están en disco (la ruta es el propio nombre)
+        to_parse[n_programs] = (file_index == -1) ? token : NULL;
+        n_programs++;
+    }
 
-            if (pid == -1)
-            {
-                printf("Error: No se pudo crear el proceso para '%s'.\n", program_name);
-                token = strtok(NULL, " \t");
-                continue;
-            }
+    LoadBatch *batch = load_batch_start(to_parse, n_programs);
+    if (batch == NULL)
+    {
+        printf("Error: No hay memoria para preparar la carga.\n");
+        return;
+    }
 
-            printf("Proceso creado con PID %d.\n", pid);
-        }
+    // Paso 4: Admitir programas en orden e ir ejecutando los que ya están en RAM
+    int next = 0;
+    int programs_loaded = 0;
+    bool running = false;
 
-        // Paso 6: Buscar partición libre
-        int partition_id = find_free_partition();
+    while (next < n_programs || (running && hay_procesos_activos()))
+    {
+        bool activos = hay_procesos_activos();
 
-        if (partition_id == -1)
+        // Si la CPU no tiene nada que hacer se espera al parseo; si no, sólo se admite lo que ya está listo.
+        // Sin partición libre el programa espera a que termine algún proceso.
+        if (next < n_programs && (!activos || (load_batch_ready(batch, next) && hay_particion_libre())))
         {
-            printf("Error: No hay memoria RAM disponible para '%s'.\n", program_name);
-            token = strtok(NULL, " \t");
-            continue;
-        }
+            if (admitir_programa(batch, next, names[next]) != -1)
+                programs_loaded++;
+            next++;
 
-        printf("Partición %d asignada.\n", partition_id);
+            if (!running && hay_procesos_activos())
+            {
+                if (next < n_programs)
+                    printf("\n--- Ejecutando (el resto de la lista se sigue cargando) ---\n");
+                else
+                    printf("\n--- Ejecutando %d programa(s) ---\n", programs_loaded);
+                running = true;
+            }
 
-        // Paso 7: Cargar a RAM
-        if (load_program_to_ram(pid, partition_id, file_index) != 0)
-        {
-            printf("Error: No se pudo cargar '%s' a memoria RAM.\n", program_name);
-            token = strtok(NULL, " \t");
+            // Dejamos que el planificador elija al proceso si la CPU estaba libre
+            if (current_pid == NULL_PID)
+                schedule();
             continue;
         }
 
-        printf("Programa '%s' cargado en RAM.\n", program_name);
-
-        // Paso 8: Dispatch
-        printf("Proceso %d (%s) listo para ejecutar.\n", pid, program_name);
-
-        programs_loaded++;
-
-        // Siguiente programa
-        token = strtok(NULL, " \t");
-    }
-
-    if (programs_loaded == 0)
-    {
-        printf("No se pudo cargar ningún programa.\n");
-        return;
-    }
-
-    printf("\n--- Ejecutando %d programa(s) ---\n", programs_loaded);
-    // Dejamos que el planificador elija al primer proceso de la cola
-    schedule();
+        if (!activos)
+            continue;
 
-    // Paso 9: Bucle de ejecución CPU
-    while (1)
-    {
+        // Paso 5: Un ciclo de CPU
         int ret = cpu();
 
         // Caso 1: Error fatal reportado por CPU
@@ -383,20 +729,37 @@ void cmd_ejecutar(const char *program_list_arg)
         }
 
         // Caso 2: Verificar si hay procesos activos
-        if (!hay_procesos_activos())
+        if (next >= n_programs && !hay_procesos_activos())
         {
             printf(">> No hay más procesos activos.\n");
             break;
         }
     }
 
+    load_batch_destroy(batch);
+
+    if (programs_loaded == 0)
+    {
+        printf("No se pudo cargar ningún programa.\n");
+        return;
+    }
+
+    printf("\n%d programa(s) ejecutado(s).\n", programs_loaded);
+    console_output_flush_all();
     printf("\nEjecución completada.\n");
 }
 
 // --- MAIN LOOP ---
-int main()
+int main(int argc, char *argv[])
 {
     log_init();
+
+    // Uso: ./simulador [imagen_disco]
+    if (argc > 1)
+    {
+        disk_set_image_path(argv[1]);
+    }
+
     if (system_init() != 0)
     {
         write_log(1, "FATAL: No se pudo iniciar el sistema. Saliendo...\n");
@@ -412,11 +775,10 @@ int main()
     {
         char comando[256];
         printf("Shell> ");
-        if (fgets(comando, sizeof(comando), stdin) == NULL)
+        fflush(stdout);
+        if (console_read_line(comando, sizeof(comando)) != 0)
             break;
 
-        comando[strcspn(comando, "\n")] = '\0'; // Elimina salto de línea
-
         // --- COMANDO: APAGAR ---
         if (strcmp(comando, "apagar") == 0)
         {
@@ -437,6 +799,51 @@ int main()
         {
             cmd_memestat();
         }
+        // --- COMANDO: DISKSTAT ---
+        else if (strncmp(comando, "diskstat", 8) == 0 && (comando[8] == '\0' || comando[8] == ' '))
+        {
+            cmd_diskstat(comando + 8);
+        }
+        // --- COMANDO: CACHESTAT ---
+        else if (strcmp(comando, "cachestat") == 0)
+        {
+            cmd_cachestat();
+        }
+        // --- COMANDO: SYNC ---
+        else if (strcmp(comando, "sync") == 0)
+        {
+            cmd_sync();
+        }
+        // --- COMANDO: BORRAR ---
+        else if (strncmp(comando, "borrar ", 7) == 0)
+        {
+            cmd_borrar(comando + 7);
+        }
+        // --- COMANDO: CONVERTIR ---
+        else if (strncmp(comando, "convertir ", 10) == 0)
+        {
+            cmd_convertir(comando + 10);
+        }
+        // --- COMANDO: ENTRADA ---
+        else if (strncmp(comando, "entrada", 7) == 0 && (comando[7] == '\0' || comando[7] == ' '))
+        {
+            cmd_entrada(comando + 7);
+        }
+        // --- COMANDO: SALIDA ---
+        else if (strncmp(comando, "salida", 6) == 0 && (comando[6] == '\0' || comando[6] == ' '))
+        {
+            cmd_salida(comando + 6);
+        }
+        // --- COMANDO: IPCS ---
+        else if (strcmp(comando, "ipcs") == 0)
+        {
+            cmd_ipcs();
+        }
+        // --- COMANDO: FORMATEAR ---
+        else if (strcmp(comando, "formatear") == 0)
+        {
+            cmd_formatear();
+        }
         // --- COMANDO: EJECUTAR ---
         else if (strncmp(comando, "ejecutar ", 9) == 0)
         {
@@ -0,0 +1,127 @@
+#include "pipe.h"
+#include "bus.h"
+#include "log.h"
+#include <string.h>
+
+static PipeInfo pipes[PIPE_MAX];
+
+void pipe_init()
+{
+    memset(pipes, 0, sizeof(pipes));
+    for (int i = 0; i < PIPE_MAX; i++)
+        pipes[i].base = PIPE_POOL_START + i * PIPE_CAPACITY;
+}
+
+int pipe_open(int key, int ends)
+{
+    int id = -1;
+    for (int i = 0; i < PIPE_MAX; i++)
+    {
+        if (pipes[i].in_use && pipes[i].key == key)
+        {
+            id = i;
+            break;
+        }
+        if (!pipes[i].in_use && id == -1)
+            id = i;
+    }
+
+    if (id == -1)
+    {
+        write_log(1, "PIPE: No quedan tubos libres para la clave %d.\n", key);
+        return -1;
+    }
+
+    PipeInfo *p = &pipes[id];
+    if (!p->in_use)
+    {
+        int base = p->base;
+        memset(p, 0, sizeof(*p));
+        p->base = base;
+        p->in_use = 1;
+        p->key = key;
+        write_log(0, "PIPE: Tubo %d creado (clave %d, Dir %d a %d).\n",
+                  id, key, base, base + PIPE_CAPACITY - 1);
+    }
+
+    if (ends & PIPE_END_READ)
+    {
+        p->readers++;
+        p->had_reader = 1;
+    }
+    if (ends & PIPE_END_WRITE)
+    {
+        p->writers++;
+        p->had_writer = 1;
+    }
+    return id;
+}
+
+void pipe_close(int id, int ends)
+{
+    if (id < 0 || id >= PIPE_MAX || !pipes[id].in_use)
+        return;
+
+    if ((ends & PIPE_END_READ) && pipes[id].readers > 0)
+        pipes[id].readers--;
+    if ((ends & PIPE_END_WRITE) && pipes[id].writers > 0)
+        pipes[id].writers--;
+
+    if (pipes[id].readers != 0 || pipes[id].writers != 0)
+        return;
+
+    // Lo que escribió un productor que ya terminó espera a que algún lector lo saque
+    if (pipes[id].count > 0 && !pipes[id].had_reader)
+    {
+        write_log(0, "PIPE: Tubo %d (clave %d) sin extremos abiertos. Conserva %d palabra(s) para un lector.\n",
+                  id, pipes[id].key, pipes[id].count);
+    }
+    else
+    {
+        pipes[id].in_use = 0;
+        write_log(0, "PIPE: Tubo %d (clave %d) liberado. %ld palabra(s) transferidas.\n",
+                  id, pipes[id].key, pipes[id].words_out);
+    }
+}
+
+int pipe_write(int id, const Word *words, int n)
+{
+    if (id < 0 || id >= PIPE_MAX || !pipes[id].in_use)
+        return -1;
+
+    PipeInfo *p = &pipes[id];
+    int copied = 0;
+    while (copied < n && p->count < PIPE_CAPACITY)
+    {
+        int tail = (p->head + p->count) % PIPE_CAPACITY;
+        bus_write(p->base + tail, words[copied++], 0);
+        p->count++;
+    }
+    p->words_in += copied;
+    return copied;
+}
+
+int pipe_read(int id, Word *words, int n)
+{
+    if (id < 0 || id >= PIPE_MAX || !pipes[id].in_use)
+        return -1;
+
+    PipeInfo *p = &pipes[id];
+    int copied = 0;
+    while (copied < n && p->count > 0)
+    {
+        bus_read(p->base + p->head, &words[copied++], 0);
+        p->head = (p->head + 1) % PIPE_CAPACITY;
+        p->count--;
+    }
+    p->words_out += copied;
+    return copied;
+}
+
+int pipe_get_info(int id, PipeInfo *info)
+{
+    if (id < 0 || id >= PIPE_MAX)
+        return -1;
+    *info = pipes[id];
+    return 0;
+}
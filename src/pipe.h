@@ -0,0 +1,67 @@
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "brain.h"
+
+// Tubos (pipes) entre procesos.
+// Cada tubo es un buffer circular de PIPE_CAPACITY palabras dentro de PIPE_POOL (memoria del SO).
+// Como la memoria compartida, se identifica por una clave numérica que eligen los programas.
+#define PIPE_CAPACITY 8
+#define PIPE_MAX (PIPE_POOL_WORDS / PIPE_CAPACITY)
+
+// Extremos con los que un proceso abre un tubo (se pueden combinar)
+#define PIPE_END_READ 1
+#define PIPE_END_WRITE 2
+
+typedef struct
+{
+    int in_use;    // 0 si el tubo está libre
+    int key;       // Clave con la que se creó
+    int base;      // Dirección física del buffer
+    int head;      // Próxima palabra a leer (índice en el buffer)
+    int count;     // Palabras guardadas
+    int readers;    // Extremos de lectura abiertos
+    int writers;    // Extremos de escritura abiertos
+    int had_reader; // Alguna vez tuvo lector: sin lectores, escribir es un error
+    int had_writer; // Alguna vez tuvo escritor: vacío y sin escritores = fin
+    long words_in; // Palabras escritas desde que se creó
+    long words_out;
+} PipeInfo;
+
+// Libera todos los tubos (al iniciar o reiniciar el kernel)
+void pipe_init();
+
+/**
+ * Busca el tubo con esa clave o, si no existe, lo crea vacío, y le suma los extremos dados
+ * (PIPE_END_READ y/o PIPE_END_WRITE).
+ *
+ * Retorna: id del tubo (0 a PIPE_MAX-1), o -1 si no quedan tubos libres
+ */
+int pipe_open(int key, int ends);
+
+// Cierra esos extremos del tubo; cuando no queda ninguno se libera, salvo que guarde
+// palabras que ningún lector llegó a ver (se liberan cuando un lector lo abre y lo cierra)
+void pipe_close(int id, int ends);
+
+/**
+ * Copia al tubo todas las palabras que entren (a lo sumo n).
+ *
+ * Retorna: palabras copiadas (0 si está lleno), -1 si el id no es un tubo abierto
+ */
+int pipe_write(int id, const Word *words, int n);
+
+/**
+ * Saca del tubo hasta n palabras.
+ *
+ * Retorna: palabras copiadas (0 si está vacío), -1 si el id no es un tubo abierto
+ */
+int pipe_read(int id, Word *words, int n);
+
+/**
+ * Copia los datos del tubo.
+ *
+ * Retorna: 0 si éxito, -1 si el id está fuera de rango
+ */
+int pipe_get_info(int id, PipeInfo *info);
+
+#endif // PIPE_H
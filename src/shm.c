@@ -0,0 +1,74 @@
+#include "shm.h"
+#include "bus.h"
+#include "log.h"
+#include <string.h>
+
+static ShmInfo segments[SHM_MAX_SEGMENTS];
+
+void shm_init()
+{
+    memset(segments, 0, sizeof(segments));
+    for (int i = 0; i < SHM_MAX_SEGMENTS; i++)
+    {
+        segments[i].base = SHM_POOL_START + i * SHM_SEGMENT_WORDS;
+        segments[i].size = SHM_SEGMENT_WORDS;
+    }
+}
+
+int shm_open(int key)
+{
+    int free_id = -1;
+    for (int i = 0; i < SHM_MAX_SEGMENTS; i++)
+    {
+        if (segments[i].in_use && segments[i].key == key)
+            return i;
+        if (!segments[i].in_use && free_id == -1)
+            free_id = i;
+    }
+
+    if (free_id == -1)
+    {
+        write_log(1, "SHM: No quedan segmentos libres para la clave %d.\n", key);
+        return -1;
+    }
+
+    ShmInfo *seg = &segments[free_id];
+    for (int i = 0; i < seg->size; i++)
+        bus_write(seg->base + i, 0, 0);
+
+    seg->in_use = 1;
+    seg->key = key;
+    seg->refs = 0;
+    write_log(0, "SHM: Segmento %d creado (clave %d, Dir %d a %d).\n",
+              free_id, key, seg->base, seg->base + seg->size - 1);
+    return free_id;
+}
+
+int shm_acquire(int id)
+{
+    if (id < 0 || id >= SHM_MAX_SEGMENTS || !segments[id].in_use)
+        return -1;
+    segments[id].refs++;
+    return 0;
+}
+
+void shm_release(int id)
+{
+    if (id < 0 || id >= SHM_MAX_SEGMENTS || !segments[id].in_use)
+        return;
+
+    if (--segments[id].refs <= 0)
+    {
+        segments[id].in_use = 0;
+        segments[id].refs = 0;
+        write_log(0, "SHM: Segmento %d (clave %d) liberado.\n", id, segments[id].key);
+    }
+}
+
+int shm_get_info(int id, ShmInfo *info)
+{
+    if (id < 0 || id >= SHM_MAX_SEGMENTS)
+        return -1;
+    *info = segments[id];
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef SHM_H
+#define SHM_H
+
+#include "brain.h"
+
+// Memoria compartida entre procesos.
+// Los segmentos salen de SHM_POOL (memoria del SO, ver brain.h), todos de SHM_SEGMENT_WORDS palabras.
+// Cada segmento se identifica por una clave numérica que eligen los programas; el proceso que lo
+// adjunta lo ve a partir de la dirección lógica SHM_LOGICAL_BASE (registros SB/SL del contexto).
+#define SHM_SEGMENT_WORDS 32
+#define SHM_MAX_SEGMENTS (SHM_POOL_WORDS / SHM_SEGMENT_WORDS)
+
+typedef struct
+{
+    int in_use; // 0 si el segmento está libre
+    int key;    // Clave con la que se creó
+    int base;   // Dirección física del primer word
+    int size;   // Palabras
+    int refs;   // Procesos que lo tienen (creado o adjuntado)
+} ShmInfo;
+
+// Libera todos los segmentos (al iniciar o reiniciar el kernel)
+void shm_init();
+
+/**
+ * Busca el segmento con esa clave o, si no existe, lo crea (en cero).
+ *
+ * Retorna: id del segmento (0 a SHM_MAX_SEGMENTS-1), o -1 si no quedan segmentos libres
+ */
+int shm_open(int key);
+
+/**
+ * Un proceso más usa el segmento.
+ *
+ * Retorna: 0 si éxito, -1 si el id no corresponde a un segmento creado
+ */
+int shm_acquire(int id);
+
+// Un proceso deja de usar el segmento; con el último se libera
+void shm_release(int id);
+
+/**
+ * Copia los datos del segmento.
+ *
+ * Retorna: 0 si éxito, -1 si el id está fuera de rango
+ */
+int shm_get_info(int id, ShmInfo *info);
+
+#endif // SHM_H